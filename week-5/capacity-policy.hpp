@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <iterator>
+
+/// Capacity policies decide the bucket count of a hash table and how a hash maps to a bucket
+/// Each policy provides:
+///  - initial(size) - the bucket count to start with, given the table's preferred size
+///  - grow(size) - the bucket count after a resize of a table with the given size
+///  - index(hash, size) - bucket index in [0, size) for a given hash
+
+
+/// Odd sizes growing as size * 2 + 1 and indexing with modulo
+/// Keeps the original behavior of the tables, the modulo is an integer division on every lookup
+struct ModuloCapacity {
+	size_t initial(size_t size) const {
+		return size;
+	}
+
+	size_t grow(size_t size) const {
+		return size * 2 + 1;
+	}
+
+	size_t index(size_t hash, size_t size) const {
+		return hash % size;
+	}
+};
+
+
+/// Power of two sizes with multiplicative (Fibonacci) mixing of the hash and mask instead of modulo
+/// Mixing is required as the lower bits of std::hash<int> (identity) are a poor bucket index on their own
+struct PowerOfTwoCapacity {
+	size_t initial(size_t size) const {
+		size_t result = 1;
+		while (result < size) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	size_t grow(size_t size) const {
+		return size * 2;
+	}
+
+	size_t index(size_t hash, size_t size) const {
+		return size_t(mix(hash)) & (size - 1);
+	}
+
+	/// Multiply by 2^64 / golden ratio and fold the well mixed high half onto the low bits
+	static uint64_t mix(size_t hash) {
+		const uint64_t product = uint64_t(hash) * 0x9E3779B97F4A7C15ull;
+		return product ^ (product >> 32);
+	}
+};
+
+
+/// Prime sizes roughly doubling on growth and indexing with modulo
+/// Modulo by a prime uses all bits of the hash, and prime sizes let double hashing reach every bucket
+struct PrimeCapacity {
+	size_t initial(size_t size) const {
+		return nextPrime(size);
+	}
+
+	size_t grow(size_t size) const {
+		return nextPrime(size * 2);
+	}
+
+	size_t index(size_t hash, size_t size) const {
+		return hash % size;
+	}
+
+	/// Smallest prime not less than value, trial division is fast enough since it runs once per resize
+	static size_t nextPrime(size_t value) {
+		if (value <= 2) {
+			return 2;
+		}
+		for (size_t candidate = value | 1; ; candidate += 2) {
+			bool prime = true;
+			for (size_t divisor = 3; divisor * divisor <= candidate; divisor += 2) {
+				if (candidate % divisor == 0) {
+					prime = false;
+					break;
+				}
+			}
+			if (prime) {
+				return candidate;
+			}
+		}
+	}
+};
+
+
+/// Number of buckets needed to hold count elements without exceeding maxLoadFactor
+inline size_t bucketsForCount(size_t count, float maxLoadFactor) {
+	return size_t(std::ceil(double(count) / maxLoadFactor));
+}
+
+/// Number of elements in [first, last) if it can be known without consuming the range, 0 otherwise
+template <typename InputIt>
+size_t rangeSizeHint(InputIt, InputIt, std::input_iterator_tag) {
+	return 0;
+}
+
+template <typename ForwardIt>
+size_t rangeSizeHint(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+	return size_t(std::distance(first, last));
+}
+
+template <typename It>
+size_t rangeSizeHint(It first, It last) {
+	return rangeSizeHint(first, last, typename std::iterator_traits<It>::iterator_category());
+}
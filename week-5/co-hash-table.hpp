@@ -2,10 +2,21 @@
 
 #include <vector>
 #include <unordered_map>
-
-
-/// Closed addressing hash table, templated by key, value and hash of key
-template <typename K, typename T, typename Hash = std::hash<K>>
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <utility>
+
+#include "capacity-policy.hpp"
+#include "hashers.hpp"
+#include "hash-table-stats.hpp"
+#include "parallel-for-each.hpp"
+
+/// Closed addressing hash table, templated by key, value, hash of key and capacity policy
+/// If Hash declares is_transparent, find, erase and contains accept any type comparable with K
+/// With setIncrementalRehash the table resizes gradually, moving a few buckets on each insert or erase
+/// HashStore decides if each element keeps its hash, see StoredHash
+template <typename K, typename T, typename Hash = std::hash<K>, typename Capacity = ModuloCapacity, typename HashStore = NoStoredHash>
 class COHashTable {
 public:
 	typedef std::pair<K, T> pair_type;
@@ -15,43 +26,160 @@ public:
 
 	typedef value_type & reference;
 private:
-	typedef std::vector<pair_type> bucket_type;
+	/// Element of a bucket, the hash storage is an empty base unless HashStore keeps the hash
+	struct Entry : HashStore::Slot {
+		pair_type data; ///< Key value pair
+
+		template <typename ... Args>
+		Entry(size_t hash, Args && ... args)
+			: data(std::forward<Args>(args)...) {
+			this->setHash(hash);
+		}
+	};
+
+	typedef std::vector<Entry> bucket_type;
 	typedef std::vector<bucket_type> table_type;
 
 	typedef typename bucket_type::iterator element_iterator;
 	typedef typename table_type::iterator bucket_iterator;
 
-	table_type table; /// The table data
-	int count; ///< Number of elements inserted in the table
+	table_type table; /// The table data, no buckets until the first insert
+	table_type oldTable; ///< Buckets not yet moved to table during incremental rehash, empty otherwise
+	size_t migrateIndex; ///< First bucket of oldTable not yet moved
+	int rehashStep; ///< Number of buckets moved per operation, 0 to rehash all at once
+	float maxLoad; ///< Resize when count / buckets exceeds this
+	size_t count; ///< Number of elements inserted in the table, including the ones in oldTable
 	Hash hasher; ///< Hasher object
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+	ResizeCounter resizes; ///< Number of and time spent in resizes, for stats()
+	mutable LookupSampler sampler; ///< Probe counts of sampled lookups, only with HASH_TABLE_STATS_SAMPLING
+
+	/// Get the bucket index for a given hash
+	size_t index(size_t hash) const {
+		return sizePolicy.index(hash, table.size());
+	}
+
+	/// Get iterator to the bucket for a given hash, always valid iterator
+	bucket_iterator getBucket(size_t hash) {
+		return table.begin() + index(hash);
+	}
 
-	/// Get the bucket index for a given key
-	int index(const K &key) const {
-		return hasher(key) % table.size();
+	/// Hash of an element already in the table, the stored one if there is one
+	size_t entryHash(const Entry &entry) const {
+		return entry.hashOf(entry.data.first, hasher);
 	}
 
-	/// Get iterator to the bucket for a given key, always valid iterator
-	bucket_iterator getBucket(const K &key) {
-		return table.begin() + index(key);
+	/// Check if entry holds key, whose hash is given, the keys are compared only if the stored hash matches
+	template <typename Key>
+	static bool entryMatches(const Entry &entry, size_t hash, const Key &key) {
+		return entry.mayMatch(hash) && entry.data.first == key;
 	}
 
+	/// Check if incremental rehash is in progress
+	bool migrating() const {
+		return !oldTable.empty();
+	}
+
+	/// Get iterator to the bucket in oldTable for a given hash, only valid while migrating
+	bucket_iterator getOldBucket(size_t hash) {
+		return oldTable.begin() + sizePolicy.index(hash, oldTable.size());
+	}
+
+	/// Allocate the initial buckets, the constructors and clear leave the table without any
+	void allocate() {
+		table = table_type(sizePolicy.initial(32));
+	}
+
+	/// Check if key is in the table without modifying it
+	template <typename Key>
+	bool containsKey(const Key &key) const {
+		if (table.empty()) {
+			return false;
+		}
+		const size_t hash = hasher(key);
+		size_t probes = 0;
+		for (const Entry &el : table[index(hash)]) {
+			++probes;
+			if (entryMatches(el, hash, key)) {
+				sampler.record(true, probes);
+				return true;
+			}
+		}
+		if (migrating()) {
+			for (const Entry &el : oldTable[sizePolicy.index(hash, oldTable.size())]) {
+				++probes;
+				if (entryMatches(el, hash, key)) {
+					sampler.record(true, probes);
+					return true;
+				}
+			}
+		}
+		sampler.record(false, probes);
+		return false;
+	}
+
+	/// Enables the heterogeneous lookup overloads only for transparent hashers
+	template <typename Key, typename H>
+	using enable_transparent = typename std::enable_if<IsTransparent<H>::value && !std::is_same<Key, K>::value, int>::type;
+
 	/// Check if table has reached maxLoadFactor
 	bool shouldResize() {
 		const float load = float(count) / table.size();
-		return load > 0.7;
+		return load > maxLoad;
+	}
+
+	/// Move up to bucketCount buckets from oldTable to table, releases oldTable when all are moved
+	void migrate(size_t bucketCount) {
+		const size_t stop = std::min(oldTable.size(), migrateIndex + bucketCount);
+		for (; migrateIndex < stop; ++migrateIndex) {
+			for (Entry & el : oldTable[migrateIndex]) {
+				getBucket(entryHash(el))->push_back(std::move(el));
+			}
+			// release the bucket memory right away
+			bucket_type().swap(oldTable[migrateIndex]);
+		}
+
+		if (migrateIndex == oldTable.size()) {
+			table_type().swap(oldTable);
+			migrateIndex = 0;
+		}
 	}
 
-	/// Allocate more space and re-hash the table
+	/// Called on each insert and erase, does one step of an incremental rehash if there is one
+	void migrateStep() {
+		if (migrating()) {
+			migrate(rehashStep);
+		}
+	}
+
+	/// Start incremental rehash or rehash everything if it is disabled
 	void resize() {
-		table_type newTable(table.size() * 2 + 1);
+		ResizeCounter::Scope measure(resizes);
+		// the previous incremental rehash must finish before a new one starts
+		migrate(oldTable.size());
+
+		if (!rehashStep) {
+			rehashAll(sizePolicy.grow(table.size()));
+			return;
+		}
+
+		oldTable = table_type(sizePolicy.grow(table.size()));
+		oldTable.swap(table);
+		migrateIndex = 0;
+	}
+
+	/// Allocate newSize buckets and re-hash the table
+	void rehashAll(size_t newSize) {
+		table_type newTable(newSize);
 		// swap the tables now so we can use the private utility methods (index, getBucket)
 		table.swap(newTable);
 
 		for (bucket_type & bucket : newTable) {
-			for (pair_type & el : bucket) {
+			for (Entry & el : bucket) {
 				// directly insert to avoid checking for duplicating keys
 				// since this is called only on valid elements, duplicate keys will not be present
-				getBucket(el.first)->push_back(std::make_pair(el.first, el.second));
+				// the source is cleared right after, so elements can be moved
+				getBucket(entryHash(el))->push_back(std::move(el));
 			}
 			// clear this source bucket since all elements from it are transferred to the new table
 			// this will allow the resize() method to only require O(n) + O(largestBucket) memory
@@ -60,27 +188,90 @@ private:
 	}
 
 public:
-	COHashTable(Hash hasher = Hash())
-		: table(32)
+	/// Allocates nothing, the buckets are created by the first insert
+	COHashTable(Hash hasher = Hash(), Capacity capacity = Capacity())
+		: migrateIndex(0)
+		, rehashStep(0)
+		, maxLoad(0.7f)
 		, count(0)
-		, hasher(hasher) {
+		, hasher(hasher)
+		, sizePolicy(capacity) {
 	}
 
+	/// Construct from a range of key-value pairs, the table is sized once for forward ranges
+	/// For duplicate keys the first one is kept
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	COHashTable(InputIt first, InputIt last, Hash hasher = Hash(), Capacity capacity = Capacity())
+		: COHashTable(hasher, capacity) {
+		insert(first, last);
+	}
+
+	/// Remove all elements and release the buckets
 	void clear() {
-		table = table_type(32);
+		table_type().swap(table);
+		table_type().swap(oldTable);
+		migrateIndex = 0;
 		count = 0;
 	}
 
+	/// Number of buckets in the table, not counting the old ones during incremental rehash
+	size_t bucket_count() const {
+		return table.size();
+	}
+
+	float max_load_factor() const {
+		return maxLoad;
+	}
+
+	/// Set the load factor above which the table grows, rehashes now if it is already exceeded
+	void max_load_factor(float factor) {
+		assert(factor > 0);
+		maxLoad = factor;
+		if (shouldResize()) {
+			rehash(0);
+		}
+	}
+
+	/// Set the bucket count to at least buckets and enough for size() elements, re-hashes all elements right away
+	void rehash(size_t buckets) {
+		ResizeCounter::Scope measure(resizes);
+		migrate(oldTable.size());
+		const size_t needed = std::max(buckets, bucketsForCount(count, maxLoad));
+		rehashAll(sizePolicy.initial(std::max<size_t>(needed, 1)));
+	}
+
+	/// Make room for elementCount elements so inserting up to that many does not resize
+	void reserve(size_t elementCount) {
+		const size_t needed = bucketsForCount(elementCount, maxLoad);
+		if (needed > table.size()) {
+			rehash(needed);
+		}
+	}
+
+	/// Enable incremental rehash moving bucketsPerStep buckets on each insert or erase, 0 disables it
+	/// Iterators are invalidated by each insert and erase by key while a rehash is in progress
+	void setIncrementalRehash(int bucketsPerStep) {
+		assert(bucketsPerStep >= 0);
+		rehashStep = bucketsPerStep;
+		if (!rehashStep) {
+			migrate(oldTable.size());
+		}
+	}
+
 	class iterator {
 		// friend the container so it can access the private constructors
 		friend class COHashTable;
 		
-		table_type *table; ///< Pointer so the iterators can be easily copy-able
+		COHashTable *owner; ///< Pointer so the iterators can be easily copy-able
+		table_type *table; ///< The owner's table or oldTable the iterator is currently in
 		bucket_iterator bucket; ///< Iterator to the current bucket
 		element_iterator element; ///< Iterator to the current element
 
-		/// Creates the begin iterator for the given table
-		iterator(table_type &tableRef): table(&tableRef) {
+		/// Creates the begin iterator for the given table, oldTable is walked first while migrating
+		iterator(COHashTable &ownerRef)
+			: owner(&ownerRef)
+			, table(ownerRef.migrating() ? &ownerRef.oldTable : &ownerRef.table)
+		{
 			// bucket will never be table->end(), because the table will always have some buckets
 			bucket = table->begin();
 			element = bucket->begin();
@@ -88,8 +279,9 @@ public:
 		}
 
 		/// Creates iterator to a specific element
-		iterator(table_type &table, bucket_iterator bucket, element_iterator element)
-			: table(&table)
+		iterator(COHashTable &owner, table_type &table, bucket_iterator bucket, element_iterator element)
+			: owner(&owner)
+			, table(&table)
 			, bucket(bucket)
 			, element(element)
 		{}
@@ -102,7 +294,7 @@ public:
 		const_pair & operator*() const {
 			// cast from pair_type -> to const_key_pair_type
 			// we can safely reinterpret this as they are binary the same 
-			return reinterpret_cast<const_pair &>(*element);
+			return reinterpret_cast<const_pair &>(element->data);
 		}
 
 		const_pair * operator->() const {
@@ -141,77 +333,228 @@ public:
 		/// If element is end iterator of current bucket, find the next valid bucket or
 		/// get to end() if there are none
 		void findNextValid() {
-			// already valid element
-			if (element != bucket->end()) {
-				return;
-			}
-
 			// find first bucket with elements
-			do {
+			while (element == bucket->end()) {
 				++bucket;
-			} while (bucket != table->end() && bucket->empty());
-
-			// if bucket reached table->end(), make this end() iterator
-			if (bucket != table->end()) {
+				if (bucket == table->end()) {
+					// if bucket reached the end of the current table, make this end() iterator
+					if (table != &owner->oldTable) {
+						element = table->back().end(); // end iterator
+						return;
+					}
+					// finished walking oldTable, continue in the current table
+					table = &owner->table;
+					bucket = table->begin();
+				}
 				element = bucket->begin();
-			} else {
-				element = table->back().end(); // end iterator
 			}
 		}
 	};
 
 	/// Iterator to first element or end() if table is empty
 	iterator begin() {
-		return iterator(table);
+		return table.empty() ? end() : iterator(*this);
 	}
 
 	/// End iterator, can only be used for equality check
 	iterator end() {
-		return iterator(table, table.end(), table.back().end());
+		return iterator(*this, table, table.end(), table.empty() ? element_iterator() : table.back().end());
+	}
+
+private:
+	/// Iterator to the first element in bucket position or after it, while migrating the oldTable buckets come first
+	iterator iteratorAtBucket(size_t position) {
+		const size_t oldBuckets = migrating() ? oldTable.size() : 0;
+		if (position >= oldBuckets + table.size()) {
+			return end();
+		}
+		table_type &current = position < oldBuckets ? oldTable : table;
+		const bucket_iterator bucket = current.begin() + (position < oldBuckets ? position : position - oldBuckets);
+		iterator it(*this, current, bucket, bucket->begin());
+		it.findNextValid();
+		return it;
+	}
+
+public:
+	/// Split the elements into up to count ranges of buckets that can be walked independently, e.g. from different threads
+	/// The ranges are invalidated by anything that invalidates iterators, including inserts while migrating
+	std::vector<IteratorRange<iterator>> partitions(size_t count) {
+		const size_t buckets = (migrating() ? oldTable.size() : 0) + table.size();
+		return partitionBuckets<iterator>(count, buckets, [this](size_t position) {
+			return iteratorAtBucket(position);
+		});
+	}
+
+	/// Call fn(element) for every element from threads threads, the table must not be modified meanwhile
+	/// fn may change the values and must be safe to call concurrently for different elements
+	template <typename Fn>
+	void parallel_for_each(Fn fn, int threads) {
+		parallelForEach(*this, fn, threads);
 	}
 
 	/// Find an element by its key, returns iterator to the element or end() if not found
 	iterator find(const K &key) {
-		bucket_iterator bucket = getBucket(key);
+		return findKey(key);
+	}
+
+	/// Find an element by any key type the transparent hasher accepts, without converting it to K
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	iterator find(const Key &key) {
+		return findKey(key);
+	}
+
+	/// Check if key is in the table
+	bool contains(const K &key) const {
+		return containsKey(key);
+	}
+
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	bool contains(const Key &key) const {
+		return containsKey(key);
+	}
+
+private:
+	/// Find the key with the given hash in a bucket, returns bucket->end() if not present
+	template <typename Key>
+	element_iterator findInBucket(bucket_iterator bucket, size_t hash, const Key &key) {
 		for (element_iterator elIter = bucket->begin(); elIter != bucket->end(); ++elIter) {
-			if (elIter->first == key) {
-				return iterator(table, bucket, elIter);
+			if (entryMatches(*elIter, hash, key)) {
+				return elIter;
 			}
 		}
+		return bucket->end();
+	}
+
+	template <typename Key>
+	iterator findKey(const Key &key) {
+		return table.empty() ? end() : findKey(key, hasher(key));
+	}
+
+	/// Find the key in table and, while migrating, in oldTable
+	template <typename Key>
+	iterator findKey(const Key &key, size_t hash) {
+		bucket_iterator bucket = getBucket(hash);
+		element_iterator element = findInBucket(bucket, hash, key);
+		if (element != bucket->end()) {
+			sampler.record(true, element - bucket->begin() + 1);
+			return iterator(*this, table, bucket, element);
+		}
+		size_t probes = bucket->size();
+
+		if (migrating()) {
+			bucket = getOldBucket(hash);
+			element = findInBucket(bucket, hash, key);
+			if (element != bucket->end()) {
+				sampler.record(true, probes + (element - bucket->begin()) + 1);
+				return iterator(*this, oldTable, bucket, element);
+			}
+			probes += bucket->size();
+		}
+		sampler.record(false, probes);
 		return end();
 	}
 
-	/// Insert key-value pair, if key is already present in the table, overwrites the value
-	iterator insert(const K &key, const T &value) {
-		// do check before inserting as it can invalidate iterators!
+	/// Look up the key once and if not present construct the value in place from args
+	/// Returns iterator to the element and true if it was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		// migrate before the lookup so the returned iterator is not invalidated
+		migrateStep();
+		if (table.empty()) {
+			allocate();
+		}
+
+		const size_t hash = hasher(key);
+		iterator found = findKey(key, hash);
+		if (found != end()) {
+			return std::make_pair(found, false);
+		}
+		bucket_iterator bucket = getBucket(hash);
+
+		// resize only when actually inserting, it invalidates the bucket
 		if (shouldResize()) {
 			resize();
+			bucket = getBucket(hash);
 		}
 
-		bucket_iterator bucket = getBucket(key);
-		for (element_iterator elIter = bucket->begin(); elIter != bucket->end(); ++elIter) {
-			// if key matches, return iterator to it
-			if (elIter->first == key) {
-				// overwrite the value
-				elIter->second = value;
-				return iterator(table, bucket, elIter);
-			}
+		++count;
+		bucket->emplace_back(hash, std::piecewise_construct,
+			std::forward_as_tuple(std::forward<KeyArg>(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		return std::make_pair(iterator(*this, table, bucket, bucket->end() - 1), true);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		std::pair<iterator, bool> result = tryEmplace(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			result.first.element->data.second = std::forward<Value>(value);
 		}
+		return result;
+	}
 
-		++count;
-		element_iterator element = bucket->insert(bucket->end(), std::make_pair(key, value));
-		return iterator(table, bucket, element);
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
+
+	/// Insert a range of key-value pairs without overwriting existing keys, reserves space once for forward ranges
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		reserve(count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			tryEmplace(first->first, first->second);
+		}
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
+
+	/// Insert or overwrite the value for key, returns iterator to the element and true if it was inserted
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value in place from args, otherwise do nothing
+	/// Returns iterator to the element and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	/// Returns iterator to the element with that key and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		// the key is needed to find the bucket, so the pair is constructed before the lookup
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
 	}
 
 	/// Get value reference to an element with given key,
 	/// if key is not in the table, default construct the value and insert it
 	reference operator[](const K &key) {
-		iterator it = find(key);
-		if (it == end()) {
-			return insert(key, T())->second;
-		} else {
-			return it->second;
-		}
+		return tryEmplace(key).first.element->data.second;
+	}
+
+	reference operator[](K &&key) {
+		return tryEmplace(std::move(key)).first.element->data.second;
 	}
 
 	/// Erase the element pointed by the iterator and return iterator to the next element
@@ -230,11 +573,49 @@ public:
 	/// Erase item by key, returns iterator to next valid element
 	/// If key is not in the map, return end() iterator
 	iterator erase(const K &key) {
-		return erase(find(key));
+		migrateStep();
+		return erase(findKey(key));
+	}
+
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	iterator erase(const Key &key) {
+		migrateStep();
+		return erase(findKey(key));
 	}
 
 	/// Get the number of key-value pairs in the table
-	int size() const {
+	size_t size() const {
 		return count;
 	}
+
+	/// Chain length and probe histograms computed by walking every bucket, O(size() + bucket_count())
+	/// During an incremental rehash the chains left in the old table count as chains of their own, and
+	/// their elements are found after the whole chain of their bucket in the new table
+	HashTableStats stats() const {
+		HashTableStats result;
+		result.size = count;
+		result.bucketCount = table.size();
+		result.loadFactor = table.empty() ? 0 : double(count) / table.size();
+		resizes.fill(result);
+		sampler.fill(result);
+
+		for (const bucket_type &bucket : table) {
+			// a missing key is compared with the whole chain, the n-th element is found after n comparisons
+			result.chainLength.add(bucket.size());
+			result.missProbes.add(bucket.size());
+			for (size_t probes = 1; probes <= bucket.size(); probes++) {
+				result.hitProbes.add(probes);
+			}
+		}
+
+		for (size_t c = migrateIndex; migrating() && c < oldTable.size(); c++) {
+			const bucket_type &bucket = oldTable[c];
+			result.chainLength.add(bucket.size());
+			result.missProbes.add(bucket.size());
+			for (size_t probes = 1; probes <= bucket.size(); probes++) {
+				result.hitProbes.add(table[index(entryHash(bucket[probes - 1]))].size() + probes);
+			}
+		}
+		return result;
+	}
 };
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <utility>
+
+#include "capacity-policy.hpp"
+#include "probers.hpp"
+#include "parallel-for-each.hpp"
+
+/// Open addressing index of a compact table, each slot is empty, deleted or the position of an entry
+/// Slots are 1, 2, 4 or 8 bytes wide, the narrowest that fits every entry position for the slot count,
+/// so up to 253 slots take a byte each and up to 65533 slots two.
+class CompactIndex {
+public:
+	enum : size_t {
+		Empty = 0, ///< Never used, ends the probe sequences
+		Deleted = 1, ///< The entry was erased, skipped by lookups and re-used by inserts
+		FirstEntry = 2, ///< Slot value of entry 0, entry n is stored as n + FirstEntry
+	};
+private:
+	std::vector<uint64_t> storage; ///< Slot bytes, 64 bit words so any width is aligned
+	size_t slots; ///< Number of slots
+	size_t width; ///< Bytes per slot
+
+	/// There are fewer entries than slots, so the largest value is slots - 1 + FirstEntry
+	static size_t widthFor(size_t slots) {
+		const uint64_t largest = uint64_t(slots) + FirstEntry;
+		return largest <= UINT8_MAX ? 1 : largest <= UINT16_MAX ? 2 : largest <= UINT32_MAX ? 4 : 8;
+	}
+
+	template <typename Slot>
+	size_t read(size_t idx) const {
+		Slot value;
+		memcpy(&value, reinterpret_cast<const char *>(storage.data()) + idx * sizeof(Slot), sizeof(Slot));
+		return size_t(value);
+	}
+
+	template <typename Slot>
+	void write(size_t idx, size_t value) {
+		const Slot slot = Slot(value);
+		memcpy(reinterpret_cast<char *>(storage.data()) + idx * sizeof(Slot), &slot, sizeof(Slot));
+	}
+
+public:
+	/// All slots start empty
+	explicit CompactIndex(size_t slots = 0)
+		: storage((slots * widthFor(slots) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+		, slots(slots)
+		, width(widthFor(slots)) {}
+
+	void swap(CompactIndex &other) {
+		storage.swap(other.storage);
+		std::swap(slots, other.slots);
+		std::swap(width, other.width);
+	}
+
+	/// Number of slots
+	size_t size() const {
+		return slots;
+	}
+
+	size_t get(size_t idx) const {
+		assert(idx < slots);
+		switch (width) {
+		case 1: return read<uint8_t>(idx);
+		case 2: return read<uint16_t>(idx);
+		case 4: return read<uint32_t>(idx);
+		default: return read<uint64_t>(idx);
+		}
+	}
+
+	void set(size_t idx, size_t value) {
+		assert(idx < slots && value < slots + FirstEntry);
+		switch (width) {
+		case 1: write<uint8_t>(idx, value); break;
+		case 2: write<uint16_t>(idx, value); break;
+		case 4: write<uint32_t>(idx, value); break;
+		default: write<uint64_t>(idx, value); break;
+		}
+	}
+};
+
+/// Open addressing table split into a sparse index and a dense array of entries in insertion order, like CPython's dict
+/// Probing reads the narrow index slots and the hash stored in the entry, so large values are not spread over empty buckets
+/// and iterating walks only the entries, in the order the keys were inserted. That order survives resizes, and an erased
+/// key inserted again goes to the end. Erased entries stay in the array, skipped by iterators, until the next resize
+/// compacts it. Same interface as OOHashTable, iterators dereference to std::pair<const K, T> &.
+template <typename K, typename T, typename Hash = std::hash<K>, typename IndexProbe = LinearProber, typename Capacity = PowerOfTwoCapacity>
+class CompactHashTable {
+	static_assert(ProbeCoverage<IndexProbe, Capacity>::value,
+		"IndexProbe does not reach every bucket with this Capacity, lookups could loop forever; specialize ProbeCoverage if it does");
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef T value_type;
+	typedef K key_type;
+
+	typedef value_type & reference;
+private:
+	/// Element with its hash, which is compared before the key and re-used when the index is rebuilt
+	struct Entry {
+		pair_type data; ///< The key-value pair, default constructed once erased
+		size_t hash; ///< hasher(data.first)
+		bool erased; ///< Removed from the index, dropped by the next resize
+
+		template <typename KeyArg, typename ... Args>
+		Entry(size_t hash, KeyArg &&key, Args && ... args)
+			: data(std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArg>(key)), std::forward_as_tuple(std::forward<Args>(args)...))
+			, hash(hash)
+			, erased(false) {}
+	};
+
+	typedef std::vector<Entry> entries_t;
+
+	CompactIndex index; ///< Slots pointing into entries, none until the first insert
+	entries_t entries; ///< Elements in insertion order, including erased ones
+	size_t count; ///< Actual number of elements
+	float maxLoad; ///< Resize when (entries.size() + 1) / index.size() reaches this, must be below 1
+	Hash hasher; ///< The hash functor
+	IndexProbe nextIndex; ///< Functor to access next index
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+
+	size_t getIndex(size_t hash) const {
+		return sizePolicy.index(hash, index.size());
+	}
+
+	size_t getNextIndex(size_t idx, size_t hash, size_t step) const {
+		return probeNext(nextIndex, idx, index.size(), hash, step);
+	}
+
+	/// What the prober gets as the hash on every step of the probe sequence of hash, see probeStart
+	size_t getProbeHash(size_t hash) const {
+		return probeStart(nextIndex, index.size(), hash);
+	}
+
+	/// Every used or deleted slot has its entry, erased or not, so the entry count bounds the used slots
+	/// The entry about to be inserted is counted too, so even the small indices keep an empty slot to end the probing
+	bool needsResize() const {
+		const float factor = float(entries.size() + 1) / index.size();
+		return factor >= maxLoad;
+	}
+
+	/// Called when the load is reached, if it is mostly erased entries compact them into the same size
+	void resize() {
+		const bool mostlyErased = float(count) / index.size() < maxLoad / 2;
+		resize(mostlyErased ? index.size() : sizePolicy.grow(index.size()));
+	}
+
+	/// Drop the erased entries keeping the order of the rest and rebuild the index with newSize slots from the stored hashes
+	void resize(size_t newSize) {
+		entries_t live;
+		// room for every insert until the next resize, so the entries are not copied in between
+		live.reserve(std::max(count, size_t(newSize * maxLoad) + 1));
+		for (Entry &entry : entries) {
+			if (!entry.erased) {
+				live.push_back(std::move(entry));
+			}
+		}
+		entries.swap(live);
+
+		CompactIndex newIndex(newSize);
+		index.swap(newIndex);
+		for (size_t c = 0; c < entries.size(); c++) {
+			index.set(findEmptySlot(entries[c].hash), c + CompactIndex::FirstEntry);
+		}
+	}
+
+	/// First empty slot in the probe sequence of hash, only for keys that are not in the table
+	size_t findEmptySlot(size_t hash) const {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; index.get(idx) != CompactIndex::Empty; step++) {
+			idx = getNextIndex(idx, probeHash, step);
+		}
+		return idx;
+	}
+
+	/// Position of the entry holding key or entries.size() if key is not in the table
+	size_t findEntry(const K &key) const {
+		if (!index.size()) {
+			return entries.size();
+		}
+		const size_t hash = hasher(key);
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; ; step++) {
+			const size_t slot = index.get(idx);
+			if (slot == CompactIndex::Empty) {
+				return entries.size();
+			}
+			if (slot != CompactIndex::Deleted) {
+				const Entry &entry = entries[slot - CompactIndex::FirstEntry];
+				if (entry.hash == hash && entry.data.first == key) {
+					return slot - CompactIndex::FirstEntry;
+				}
+			}
+			idx = getNextIndex(idx, probeHash, step);
+		}
+	}
+
+	/// Walk the probe sequence once for a key that may be inserted
+	/// Returns the position of its entry or entries.size() if not present, in which case
+	/// freeSlot is set to the first deleted or empty slot where the key can go
+	size_t findInsertEntry(const K &key, size_t hash, size_t &freeSlot) const {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		freeSlot = index.size();
+		for (size_t step = 1; ; step++) {
+			const size_t slot = index.get(idx);
+			if (slot < CompactIndex::FirstEntry) {
+				if (freeSlot == index.size()) {
+					freeSlot = idx;
+				}
+				// only a never used slot ends the probe sequence, the key could be after a deleted one
+				if (slot == CompactIndex::Empty) {
+					return entries.size();
+				}
+			} else {
+				const Entry &entry = entries[slot - CompactIndex::FirstEntry];
+				if (entry.hash == hash && entry.data.first == key) {
+					return slot - CompactIndex::FirstEntry;
+				}
+			}
+			idx = getNextIndex(idx, probeHash, step);
+		}
+	}
+
+	/// Slot pointing to the entry at position, which must be in the index
+	size_t slotOf(size_t position) const {
+		const size_t hash = entries[position].hash;
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; index.get(idx) != position + CompactIndex::FirstEntry; step++) {
+			idx = getNextIndex(idx, probeHash, step);
+		}
+		return idx;
+	}
+
+public:
+	/// Allocates nothing, the index and entries are created by the first insert
+	CompactHashTable(Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: count(0)
+		, maxLoad(0.7f)
+		, hasher(hash)
+		, nextIndex(probe)
+		, sizePolicy(capacity) {}
+
+	/// Construct from a range of key-value pairs, the table is sized once for forward ranges
+	/// For duplicate keys the first one is kept
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	CompactHashTable(InputIt first, InputIt last, Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: CompactHashTable(hash, probe, capacity) {
+		insert(first, last);
+	}
+
+	/// Iterator over the key-value pairs in insertion order
+	class iterator {
+		friend class CompactHashTable;
+		entries_t *entries; ///< Pointer so the iterators can be easily copy-able
+		size_t idx; ///< Current entry
+
+		iterator(entries_t &entries, size_t idx)
+			: entries(&entries)
+			, idx(idx)
+		{
+			validateIterator();
+		}
+
+		/// Skip erased entries
+		void validateIterator() {
+			while (idx < entries->size() && (*entries)[idx].erased) {
+				++idx;
+			}
+		}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		const_pair & operator*() {
+			// same binary layout, const key protects the table invariants
+			return reinterpret_cast<const_pair &>((*entries)[idx].data);
+		}
+
+		const_pair * operator->() {
+			return &(operator*());
+		}
+
+		iterator& operator++() {
+			++idx;
+			validateIterator();
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		bool operator==(const iterator &other) const {
+			return entries == other.entries && idx == other.idx;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/// Oldest element or end() if table is empty
+	iterator begin() {
+		return iterator(entries, 0);
+	}
+
+	iterator end() {
+		return iterator(entries, entries.size());
+	}
+
+	/// Split the elements into up to count ranges of entries that can be walked independently, e.g. from different threads
+	/// The ranges are invalidated by anything that invalidates iterators
+	std::vector<IteratorRange<iterator>> partitions(size_t count) {
+		return partitionBuckets<iterator>(count, entries.size(), [this](size_t position) {
+			return iterator(entries, position);
+		});
+	}
+
+	/// Call fn(element) for every element from threads threads, the table must not be modified meanwhile
+	/// fn may change the values and must be safe to call concurrently for different elements
+	template <typename Fn>
+	void parallel_for_each(Fn fn, int threads) {
+		parallelForEach(*this, fn, threads);
+	}
+
+	/// Number of slots in the index
+	size_t bucket_count() const {
+		return index.size();
+	}
+
+	float max_load_factor() const {
+		return maxLoad;
+	}
+
+	/// Set the load factor at which the table grows, rehashes now if it is already reached
+	void max_load_factor(float factor) {
+		assert(factor > 0 && factor < 1);
+		maxLoad = factor;
+		if (index.size() && needsResize()) {
+			rehash(0);
+		}
+	}
+
+	/// Set the slot count to at least buckets and enough for size() elements, drops erased entries
+	void rehash(size_t buckets) {
+		// + 1 so the load is strictly below maxLoad and there is room for one insert
+		const size_t needed = std::max(buckets, bucketsForCount(count + 1, maxLoad));
+		resize(sizePolicy.initial(needed));
+	}
+
+	/// Make room for elementCount elements so inserting up to that many does not resize or move the entries
+	void reserve(size_t elementCount) {
+		const size_t needed = bucketsForCount(elementCount + 1, maxLoad);
+		if (needed > index.size()) {
+			rehash(needed);
+		}
+	}
+
+private:
+	/// Look up the key once and if not present append an entry constructed from key and args
+	/// Returns iterator to the element and true if it was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		if (!index.size()) {
+			resize(sizePolicy.initial(8));
+		}
+		const size_t hash = hasher(key);
+		size_t freeSlot;
+		const size_t position = findInsertEntry(key, hash, freeSlot);
+		if (position != entries.size()) {
+			return std::make_pair(iterator(entries, position), false);
+		}
+
+		// resize only when actually inserting, the new index has no deleted slots
+		if (needsResize()) {
+			resize();
+			freeSlot = findEmptySlot(hash);
+		}
+
+		index.set(freeSlot, entries.size() + CompactIndex::FirstEntry);
+		entries.emplace_back(hash, std::forward<KeyArg>(key), std::forward<Args>(args)...);
+		++count;
+		return std::make_pair(iterator(entries, entries.size() - 1), true);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		std::pair<iterator, bool> result = tryEmplace(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			result.first->second = std::forward<Value>(value);
+		}
+		return result;
+	}
+
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
+
+	/// Insert a range of key-value pairs without overwriting existing keys, reserves space once for forward ranges
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		reserve(count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			tryEmplace(first->first, first->second);
+		}
+	}
+
+	/// Insert or overwrite the value for key, returns iterator to the element and true if it was inserted
+	/// An existing key keeps its place in the order
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value from args, otherwise do nothing
+	/// Returns iterator to the element and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	/// Returns iterator to the element with that key and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
+	}
+
+	/// Erase an item and return iterator to the next item in insertion order or end()
+	/// Other iterators stay valid, the entry is only marked until the next resize
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+		Entry &entry = entries[it.idx];
+		assert(!entry.erased);
+		index.set(slotOf(it.idx), CompactIndex::Deleted);
+		entry.erased = true;
+		// release whatever the key and value hold now, not at the next resize
+		entry.data = pair_type();
+		--count;
+		it.validateIterator();
+		return it;
+	}
+
+	/// Erase element by key and return iterator to next element in map or end()
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get iterator for a given key or end() if key is not inserted
+	iterator find(const K &key) {
+		return iterator(entries, findEntry(key));
+	}
+
+	bool contains(const K &key) const {
+		return findEntry(key) != entries.size();
+	}
+
+	/// Get reference to a value based on a key, if not present insert default constructed value
+	T & operator[](const K &key) {
+		return tryEmplace(key).first->second;
+	}
+
+	T & operator[](K &&key) {
+		return tryEmplace(std::move(key)).first->second;
+	}
+
+	/// Remove all elements and free the index and entries
+	void clear() {
+		CompactIndex().swap(index);
+		entries_t().swap(entries);
+		count = 0;
+	}
+
+	/// Get the number of key-value pairs in the map
+	size_t size() const {
+		return count;
+	}
+};
@@ -0,0 +1,152 @@
+#include "concurrent-hash-table.hpp"
+#include "oo-hash-table.hpp"
+#include "rcu-hash-table.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/// The baseline - one COHashTable behind one global mutex
+template <typename K, typename T>
+class LockedHashTable {
+	COHashTable<K, T> table;
+	std::mutex mtx;
+public:
+	bool find(const K &key, T &value) {
+		std::lock_guard<std::mutex> lock(mtx);
+		typename COHashTable<K, T>::iterator it = table.find(key);
+		if (it == table.end()) {
+			return false;
+		}
+		value = it->second;
+		return true;
+	}
+
+	bool insert(const K &key, const T &value) {
+		std::lock_guard<std::mutex> lock(mtx);
+		const size_t before = table.size();
+		table.insert(key, value);
+		return table.size() != before;
+	}
+};
+
+/// Run opsPerThread operations on each of threadCount threads, writePercent of them are inserts,
+/// the rest are finds half of which miss. Returns million operations per second.
+template <typename Table>
+double runMix(Table &table, int threadCount, int keyCount, int opsPerThread, int writePercent) {
+	std::vector<std::thread> threads;
+	std::vector<long long> found(threadCount);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&table, &found, t, keyCount, opsPerThread, writePercent]() {
+			std::mt19937 rng(t);
+			long long hits = 0;
+			for (int c = 0; c < opsPerThread; c++) {
+				const unsigned r = rng();
+				const int key = int(r % (unsigned(keyCount) * 2));
+				if (int(r >> 24) % 100 < writePercent) {
+					table.insert(key, c);
+				} else {
+					int value;
+					hits += table.find(key, value);
+				}
+			}
+			// keep the result so the finds are not optimized out
+			found[t] = hits;
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	return double(threadCount) * opsPerThread / elapsed.count() / 1e6;
+}
+
+/// Run opsPerThread finds on each of threadCount threads, half of them miss, while one more thread
+/// writes a key every writeIntervalMs, the read mostly pattern of config and routing tables.
+/// Returns million finds per second.
+template <typename Table>
+double runReadMostly(Table &table, int threadCount, int keyCount, int opsPerThread, int writeIntervalMs) {
+	std::atomic<bool> done{false};
+	std::thread writer([&table, &done, keyCount, writeIntervalMs]() {
+		for (int c = 0; !done.load(); c++) {
+			table.insert((c % keyCount) * 2, c);
+			std::this_thread::sleep_for(std::chrono::milliseconds(writeIntervalMs));
+		}
+	});
+
+	std::vector<std::thread> threads;
+	std::vector<long long> found(threadCount);
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&table, &found, t, keyCount, opsPerThread]() {
+			std::mt19937 rng(t);
+			long long hits = 0;
+			for (int c = 0; c < opsPerThread; c++) {
+				int value;
+				hits += table.find(int(rng() % (unsigned(keyCount) * 2)), value);
+			}
+			found[t] = hits;
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	done = true;
+	writer.join();
+
+	return double(threadCount) * opsPerThread / elapsed.count() / 1e6;
+}
+
+/// Usage: concurrent-hash-table-bench [maxThreads] [keyCount] [opsPerThread] [writePercent]
+int main(int argc, char *argv[]) {
+	const int maxThreads = argc > 1 ? atoi(argv[1]) : 32;
+	const int keyCount = argc > 2 ? atoi(argv[2]) : 1000000;
+	const int opsPerThread = argc > 3 ? atoi(argv[3]) : 1000000;
+	const int writePercent = argc > 4 ? atoi(argv[4]) : 5;
+
+	printf("keys %d, ops per thread %d, writes %d%%, hardware threads %u\n",
+		keyCount, opsPerThread, writePercent, std::thread::hardware_concurrency());
+	printf("%8s %16s %16s %8s\n", "threads", "locked Mops/s", "sharded Mops/s", "speedup");
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		LockedHashTable<int, int> locked;
+		ConcurrentHashTable<int, int> sharded;
+		for (int c = 0; c < keyCount; c++) {
+			locked.insert(c * 2, c);
+			sharded.insert(c * 2, c);
+		}
+
+		const double lockedOps = runMix(locked, threads, keyCount, opsPerThread, writePercent);
+		const double shardedOps = runMix(sharded, threads, keyCount, opsPerThread, writePercent);
+		printf("%8d %16.2f %16.2f %7.2fx\n", threads, lockedOps, shardedOps, shardedOps / lockedOps);
+	}
+
+	// every RcuHashTable write copies the table, so writes are rare here instead of writePercent of the operations
+	const int writeIntervalMs = 100;
+	printf("\nread mostly, one write every %d ms\n", writeIntervalMs);
+	printf("%8s %16s %16s %8s\n", "threads", "sharded Mops/s", "rcu Mops/s", "speedup");
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		ConcurrentHashTable<int, int> sharded;
+		OOHashTable<int, int> built;
+		for (int c = 0; c < keyCount; c++) {
+			sharded.insert(c * 2, c);
+			built.insert(c * 2, c);
+		}
+		RcuHashTable<OOHashTable<int, int>> rcu(std::move(built));
+
+		const double shardedOps = runReadMostly(sharded, threads, keyCount, opsPerThread, writeIntervalMs);
+		const double rcuOps = runReadMostly(rcu, threads, keyCount, opsPerThread, writeIntervalMs);
+		printf("%8d %16.2f %16.2f %7.2fx\n", threads, shardedOps, rcuOps, rcuOps / shardedOps);
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "co-hash-table.hpp"
+
+/// Thread safe hash table splitting the keys across Shards independent COHashTables
+/// Each shard has its own reader-writer lock and resizes on its own, so threads working on different
+/// shards never contend and readers of the same shard do not block each other.
+/// There are no iterators since they would outlive the lock, values are copied out instead.
+template <typename K, typename T, typename Hash = std::hash<K>, size_t Shards = 32>
+class ConcurrentHashTable {
+	static_assert(Shards > 0, "Need at least one shard");
+
+	typedef COHashTable<K, T, Hash> table_type;
+
+	/// Shards are aligned to separate cache lines so a lock taken on one does not invalidate its neighbours
+	struct alignas(64) Shard {
+		std::shared_mutex mtx; ///< Exclusive for writers, shared for readers
+		table_type table; ///< Shard data
+	};
+
+	/// The shards, mutable since const lookups lock and use the non-const, but non-modifying, COHashTable::find
+	mutable Shard shards[Shards];
+	Hash hasher; ///< Hasher selecting the shard
+
+	/// Select shard by the high bits of the mixed hash, the shard's own table indexes with the low bits
+	Shard & getShard(const K &key) const {
+		const uint64_t mixed = PowerOfTwoCapacity::mix(hasher(key));
+		return shards[(mixed >> 32) % Shards];
+	}
+
+public:
+	typedef K key_type;
+	typedef T value_type;
+
+	ConcurrentHashTable(Hash hash = Hash())
+		: hasher(hash) {}
+
+	ConcurrentHashTable(const ConcurrentHashTable &) = delete;
+	ConcurrentHashTable & operator=(const ConcurrentHashTable &) = delete;
+
+	/// Copy the value for key into value, returns false if key is not present
+	bool find(const K &key, T &value) const {
+		Shard &shard = getShard(key);
+		std::shared_lock<std::shared_mutex> lock(shard.mtx);
+		typename table_type::iterator it = shard.table.find(key);
+		if (it == shard.table.end()) {
+			return false;
+		}
+		value = it->second;
+		return true;
+	}
+
+	/// Check if key is present in the table
+	bool contains(const K &key) const {
+		Shard &shard = getShard(key);
+		std::shared_lock<std::shared_mutex> lock(shard.mtx);
+		return shard.table.find(key) != shard.table.end();
+	}
+
+	/// Insert key-value pair, overwrites the value if key is present
+	/// Returns true if the key was not present before
+	bool insert(const K &key, const T &value) {
+		Shard &shard = getShard(key);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		const size_t before = shard.table.size();
+		shard.table.insert(key, value);
+		return shard.table.size() != before;
+	}
+
+	/// Call fn with reference to the value for key while holding the shard's lock
+	/// If key is not present a default constructed value is inserted first
+	/// Returns true if the key was not present before
+	template <typename Function>
+	bool upsert(const K &key, Function fn) {
+		Shard &shard = getShard(key);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		const size_t before = shard.table.size();
+		fn(shard.table[key]);
+		return shard.table.size() != before;
+	}
+
+	/// Erase element by key, returns true if it was present
+	bool erase(const K &key) {
+		Shard &shard = getShard(key);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		typename table_type::iterator it = shard.table.find(key);
+		if (it == shard.table.end()) {
+			return false;
+		}
+		shard.table.erase(it);
+		return true;
+	}
+
+	/// Remove all elements, shards are cleared one by one so concurrent inserts may survive
+	void clear() {
+		for (Shard &shard : shards) {
+			std::unique_lock<std::shared_mutex> lock(shard.mtx);
+			shard.table.clear();
+		}
+	}
+
+	/// Get the number of key-value pairs, exact only if there are no concurrent modifications
+	size_t size() const {
+		size_t result = 0;
+		for (Shard &shard : shards) {
+			std::shared_lock<std::shared_mutex> lock(shard.mtx);
+			result += shard.table.size();
+		}
+		return result;
+	}
+};
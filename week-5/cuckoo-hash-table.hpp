@@ -0,0 +1,498 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <utility>
+
+#include "capacity-policy.hpp"
+
+/// Second hash for cuckoo hashing derived from another hasher by multiplying with a different odd constant
+/// Distinct hashes give distinct and unrelated second hashes, keys with equal first hash still collide in both
+template <typename Hash>
+struct RemixHash {
+	Hash hasher;
+
+	template <typename Key>
+	size_t operator()(const Key &key) const {
+		const uint64_t product = uint64_t(hasher(key)) * 0xD6E8FEB86659FD93ull;
+		return size_t(product ^ (product >> 32));
+	}
+};
+
+/// Cuckoo hash table with 4 slot buckets, every key is in one of its two buckets or in a small stash
+/// find looks at two buckets and the stash (only when it is not empty), so lookups are bounded at any load.
+/// Insert evicts elements to their other bucket for a bounded number of steps, an element that is still
+/// left without a place goes to the stash, and when the stash is full the table is rebuilt twice as big.
+/// Loads of 95% work with 4 slot buckets.
+/// Inserts and erases invalidate all iterators since evictions move elements.
+template <typename K, typename T, typename Hash1 = std::hash<K>, typename Hash2 = RemixHash<std::hash<K>>>
+class CuckooHashTable {
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef T value_type;
+	typedef K key_type;
+
+	typedef value_type & reference;
+private:
+	enum : int {
+		slotsPerBucket = 4, ///< Slots in a bucket, 4 keep a bucket of small pairs in one or two cache lines
+		stashSize = 8, ///< Elements that could not be placed before the table is rebuilt
+		maxKicks = 256, ///< Evictions an insert tries before giving up on the buckets
+	};
+
+	struct Bucket {
+		pair_type data[slotsPerBucket]; ///< Key value pairs, default constructed when not used
+		uint8_t used = 0; ///< Bit c is set when data[c] holds an element
+	};
+
+	std::vector<Bucket> buckets; ///< Power of two number of buckets
+	std::vector<pair_type> stash; ///< Elements that did not fit in their buckets
+	size_t count; ///< Number of elements, including the stash
+	float maxLoad; ///< Grow when count / slots would exceed this
+	uint32_t random; ///< State for picking eviction victims
+	Hash1 hasher1; ///< Gives the first bucket
+	Hash2 hasher2; ///< Gives the second bucket
+	PowerOfTwoCapacity sizePolicy; ///< Maps hashes to buckets
+
+	/// Number of slots, also the first position of the stash in iterators
+	size_t slotCount() const {
+		return buckets.size() * slotsPerBucket;
+	}
+
+	template <typename Key>
+	size_t firstBucket(const Key &key) const {
+		return sizePolicy.index(hasher1(key), buckets.size());
+	}
+
+	template <typename Key>
+	size_t secondBucket(const Key &key) const {
+		return sizePolicy.index(hasher2(key), buckets.size());
+	}
+
+	/// Slot of key in bucket or -1
+	template <typename Key>
+	int findInBucket(const Bucket &bucket, const Key &key) const {
+		for (int c = 0; c < slotsPerBucket; c++) {
+			if ((bucket.used & (1 << c)) && bucket.data[c].first == key) {
+				return c;
+			}
+		}
+		return -1;
+	}
+
+	/// Iterator position of key: bucket * slotsPerBucket + slot, slotCount() + stash index, or end position
+	template <typename Key>
+	size_t findPosition(const Key &key) const {
+		const size_t first = firstBucket(key);
+		int slot = findInBucket(buckets[first], key);
+		if (slot >= 0) {
+			return first * slotsPerBucket + slot;
+		}
+
+		const size_t second = secondBucket(key);
+		slot = findInBucket(buckets[second], key);
+		if (slot >= 0) {
+			return second * slotsPerBucket + slot;
+		}
+
+		for (size_t c = 0; c < stash.size(); c++) {
+			if (stash[c].first == key) {
+				return slotCount() + c;
+			}
+		}
+		return slotCount() + stash.size();
+	}
+
+	/// Move element to a free slot of bucket, returns its iterator position or slotCount() if there is none
+	size_t placeInBucket(size_t bucketIndex, pair_type &element) {
+		Bucket &bucket = buckets[bucketIndex];
+		for (int c = 0; c < slotsPerBucket; c++) {
+			if (!(bucket.used & (1 << c))) {
+				bucket.data[c] = std::move(element);
+				bucket.used |= 1 << c;
+				return bucketIndex * slotsPerBucket + c;
+			}
+		}
+		return slotCount();
+	}
+
+	/// xorshift, enough to avoid evicting in cycles
+	uint32_t nextRandom() {
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		return random;
+	}
+
+	/// Put element in one of its buckets, evicting others to their second choice when both are full
+	/// Returns false if it ran out of evictions, then element holds the one left without a place
+	/// @param position - set to the slot the element passed in ended up in, slotCount() if it is the one left out
+	bool place(pair_type &element, size_t &position) {
+		const size_t first = firstBucket(element.first);
+		position = placeInBucket(first, element);
+		if (position != slotCount()) {
+			return true;
+		}
+		size_t current = secondBucket(element.first);
+		position = placeInBucket(current, element);
+		if (position != slotCount()) {
+			return true;
+		}
+
+		for (int kick = 0; kick < maxKicks; kick++) {
+			// take the place of a random element, it moves to its other bucket
+			const size_t victim = current * slotsPerBucket + nextRandom() % slotsPerBucket;
+			using std::swap;
+			swap(element, buckets[current].data[victim % slotsPerBucket]);
+			// follow the initial element, it can be evicted again further along the walk
+			if (position == slotCount()) {
+				position = victim;
+			} else if (position == victim) {
+				position = slotCount();
+			}
+
+			const size_t evictedFirst = firstBucket(element.first);
+			current = evictedFirst == current ? secondBucket(element.first) : evictedFirst;
+			const size_t placed = placeInBucket(current, element);
+			if (placed != slotCount()) {
+				if (position == slotCount()) {
+					position = placed;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Place all elements in a table of bucketCount buckets, doubling it until every element fits
+	void rebuild(size_t bucketCount) {
+		std::vector<pair_type> elements;
+		elements.reserve(count);
+		takeAll(elements);
+
+		for (size_t size = bucketCount; ; size *= 2) {
+			buckets = std::vector<Bucket>(size);
+			stash.clear();
+			size_t placed = 0;
+			for (size_t position; placed < elements.size(); placed++) {
+				if (!place(elements[placed], position)) {
+					if (stash.size() == stashSize) {
+						break;
+					}
+					stash.push_back(std::move(elements[placed]));
+				}
+			}
+			if (placed == elements.size()) {
+				return;
+			}
+
+			// elements[placed] holds the one left out, the placed ones go back to the list for the next try
+			std::vector<pair_type> rest(std::make_move_iterator(elements.begin() + placed), std::make_move_iterator(elements.end()));
+			elements.clear();
+			takeAll(elements);
+			for (pair_type &element : rest) {
+				elements.push_back(std::move(element));
+			}
+		}
+	}
+
+	/// Move every element out of the buckets and the stash into elements
+	void takeAll(std::vector<pair_type> &elements) {
+		for (Bucket &bucket : buckets) {
+			for (int c = 0; c < slotsPerBucket; c++) {
+				if (bucket.used & (1 << c)) {
+					elements.push_back(std::move(bucket.data[c]));
+				}
+			}
+			bucket.used = 0;
+		}
+		for (pair_type &element : stash) {
+			elements.push_back(std::move(element));
+		}
+		stash.clear();
+	}
+
+	/// Insert an element whose key is not in the table and return its iterator position
+	size_t insertNew(pair_type &element) {
+		if (count + 1 > maxLoad * slotCount()) {
+			rebuild(sizePolicy.grow(buckets.size()));
+		}
+		size_t position;
+		while (!place(element, position)) {
+			if (stash.size() < stashSize) {
+				stash.push_back(std::move(element));
+				if (position == slotCount()) {
+					position = slotCount() + stash.size() - 1;
+				}
+				break;
+			}
+			// the rebuild moves every element, so if the new one has a slot it trades it with the one left out,
+			// the rebuild takes whatever the slots hold and the new element is placed again after it
+			if (position != slotCount()) {
+				using std::swap;
+				swap(element, buckets[position / slotsPerBucket].data[position % slotsPerBucket]);
+			}
+			rebuild(sizePolicy.grow(buckets.size()));
+		}
+		++count;
+		return position;
+	}
+
+public:
+	CuckooHashTable(Hash1 hash1 = Hash1(), Hash2 hash2 = Hash2())
+		: buckets(8)
+		, count(0)
+		, maxLoad(0.95f)
+		, random(0x9E3779B9u)
+		, hasher1(hash1)
+		, hasher2(hash2) {}
+
+	/// Construct from a range of key-value pairs, for repeated keys the first one wins
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	CuckooHashTable(InputIt first, InputIt last, Hash1 hash1 = Hash1(), Hash2 hash2 = Hash2())
+		: CuckooHashTable(hash1, hash2) {
+		insert(first, last);
+	}
+
+	void clear() {
+		buckets = std::vector<Bucket>(8);
+		stash.clear();
+		count = 0;
+	}
+
+	/// Number of slots, size() / bucket_count() is the load factor
+	size_t bucket_count() const {
+		return slotCount();
+	}
+
+	float max_load_factor() const {
+		return maxLoad;
+	}
+
+	/// Set the load the table grows at, it may grow earlier when inserts fail
+	void max_load_factor(float factor) {
+		assert(factor > 0 && factor <= 1);
+		maxLoad = factor;
+		if (count > maxLoad * slotCount()) {
+			reserve(count);
+		}
+	}
+
+	/// Rebuild with at least slots slots and enough of them for the current elements at max_load_factor
+	void rehash(size_t slots) {
+		// + 1 so the load is strictly below maxLoad and there is room for one insert
+		const size_t needed = std::max(slots, bucketsForCount(count + 1, maxLoad));
+		rebuild(sizePolicy.initial((needed + slotsPerBucket - 1) / slotsPerBucket));
+	}
+
+	/// Make room for elementCount elements so inserting up to that many does not grow for the load
+	/// An insert can still grow the table when its eviction walk fails and the stash is full
+	void reserve(size_t elementCount) {
+		const size_t needed = bucketsForCount(elementCount + 1, maxLoad);
+		if (needed > slotCount()) {
+			rehash(needed);
+		}
+	}
+
+	class iterator {
+		friend class CuckooHashTable;
+		CuckooHashTable *owner; ///< Pointer so the iterators can be easily copy-able
+		size_t position; ///< Slot index, then stash index after slotCount()
+
+		iterator(CuckooHashTable &owner, size_t position)
+			: owner(&owner)
+			, position(position)
+		{
+			findNextValid();
+		}
+
+		/// Skip unused slots
+		void findNextValid() {
+			const size_t slots = owner->slotCount();
+			while (position < slots && !(owner->buckets[position / slotsPerBucket].used & (1 << (position % slotsPerBucket)))) {
+				++position;
+			}
+		}
+
+		pair_type & element() const {
+			const size_t slots = owner->slotCount();
+			return position < slots ? owner->buckets[position / slotsPerBucket].data[position % slotsPerBucket] : owner->stash[position - slots];
+		}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		const_pair & operator*() const {
+			// same binary layout, const key protects the table invariants
+			return reinterpret_cast<const_pair &>(element());
+		}
+
+		const_pair * operator->() const {
+			return &(operator*());
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		iterator& operator++() {
+			++position;
+			findNextValid();
+			return *this;
+		}
+
+		bool operator==(const iterator &other) const {
+			return owner == other.owner && position == other.position;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/// Iterator to first element or end() if table is empty
+	iterator begin() {
+		return iterator(*this, 0);
+	}
+
+	/// End iterator, can only be used for equality check
+	iterator end() {
+		return iterator(*this, slotCount() + stash.size());
+	}
+
+	/// Find an element by its key, looks in at most two buckets and the stash
+	iterator find(const K &key) {
+		return iterator(*this, findPosition(key));
+	}
+
+	bool contains(const K &key) const {
+		return findPosition(key) != slotCount() + stash.size();
+	}
+
+private:
+	/// Look up the key and if not present construct the value from args and insert it
+	/// Returns iterator to the element and true if it was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		const size_t position = findPosition(key);
+		if (position != slotCount() + stash.size()) {
+			return std::make_pair(iterator(*this, position), false);
+		}
+
+		pair_type element(std::piecewise_construct,
+			std::forward_as_tuple(std::forward<KeyArg>(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		return std::make_pair(iterator(*this, insertNew(element)), true);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		std::pair<iterator, bool> result = tryEmplace(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			result.first.element().second = std::forward<Value>(value);
+		}
+		return result;
+	}
+
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
+
+	/// Insert a range of key-value pairs, keys already in the table keep their values
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		reserve(count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			tryEmplace(first->first, first->second);
+		}
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value from args, otherwise do nothing
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
+	}
+
+	/// Get value reference to an element with given key,
+	/// if key is not in the table, default construct the value and insert it
+	reference operator[](const K &key) {
+		return tryEmplace(key).first.element().second;
+	}
+
+	reference operator[](K &&key) {
+		return tryEmplace(std::move(key)).first.element().second;
+	}
+
+	/// Erase the element pointed by the iterator and return iterator to the next element
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+
+		const size_t slots = slotCount();
+		if (it.position < slots) {
+			Bucket &bucket = buckets[it.position / slotsPerBucket];
+			const int slot = int(it.position % slotsPerBucket);
+			// release any resources held by the pair
+			bucket.data[slot] = pair_type();
+			bucket.used &= ~(1 << slot);
+		} else {
+			// the following stash elements shift down, so the same position is the next element
+			stash.erase(stash.begin() + (it.position - slots));
+		}
+		--count;
+		it.findNextValid();
+		return it;
+	}
+
+	/// Erase item by key, returns iterator to next valid element
+	/// If key is not in the map, return end() iterator
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get the number of key-value pairs in the table
+	size_t size() const {
+		return count;
+	}
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+/// Epoch based reclamation: tells writers when no reader can still see an object they unpublished
+/// A reader pins the current global epoch for the duration of a read section, a writer retires an object
+/// with the epoch at which it was unpublished and may free it once every pinned reader has a later epoch.
+/// Pinning is a load of the global epoch, a store to the thread's own record and a fence,
+/// with no lock and no read-modify-write, so readers on different cores never write a shared cache line.
+/// There is one process wide domain, shared by all tables, so each thread registers only once.
+class EpochDomain {
+public:
+	enum : uint64_t {
+		Quiescent = 0, ///< Record value of a thread outside any read section
+	};
+private:
+	/// Per thread state, on its own cache line so pinning does not invalidate other readers' lines
+	/// Records are never freed, a thread that exits releases its record for the next new thread
+	struct alignas(64) Record {
+		std::atomic<uint64_t> epoch{Quiescent}; ///< Epoch pinned by the owning thread or Quiescent
+		std::atomic<bool> used{true}; ///< Owned by a live thread
+		unsigned depth = 0; ///< Nesting of read sections, only touched by the owning thread
+		Record *next = nullptr; ///< Next record in the list, set once before the record is published
+	};
+
+	/// Releases the thread's record when the thread exits
+	struct ThreadRecord {
+		Record *record = nullptr;
+
+		~ThreadRecord() {
+			if (record) {
+				assert(record->depth == 0 && "Thread exits inside a read section");
+				record->used.store(false, std::memory_order_release);
+			}
+		}
+	};
+
+	std::atomic<uint64_t> globalEpoch{1}; ///< Advanced by writers, Quiescent is never a valid epoch
+	std::atomic<Record *> records{nullptr}; ///< All records ever registered, pushed at the front
+
+	EpochDomain() = default;
+
+	/// Re-use a released record or push a new one, once per thread
+	Record * acquireRecord() {
+		for (Record *record = records.load(std::memory_order_acquire); record; record = record->next) {
+			bool released = false;
+			if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(released, true, std::memory_order_acquire)) {
+				return record;
+			}
+		}
+		Record *record = new Record();
+		Record *head = records.load(std::memory_order_relaxed);
+		do {
+			record->next = head;
+		} while (!records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+		return record;
+	}
+
+	Record & threadRecord() {
+		static thread_local ThreadRecord local;
+		if (!local.record) {
+			local.record = acquireRecord();
+		}
+		return *local.record;
+	}
+
+public:
+	EpochDomain(const EpochDomain &) = delete;
+	EpochDomain & operator=(const EpochDomain &) = delete;
+
+	/// The process wide domain
+	static EpochDomain & instance() {
+		static EpochDomain domain;
+		return domain;
+	}
+
+	/// Start a read section, objects published before it stay alive until the matching unpin
+	/// Nested sections pin only once
+	void pin() {
+		Record &record = threadRecord();
+		if (record.depth++) {
+			return;
+		}
+		record.epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		// the pin must be visible to writers before this thread reads any published pointer, pairs with the fence in safeEpoch
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	/// End a read section
+	void unpin() {
+		Record &record = threadRecord();
+		assert(record.depth > 0);
+		if (--record.depth == 0) {
+			record.epoch.store(Quiescent, std::memory_order_release);
+		}
+	}
+
+	/// Called by a writer after unpublishing an object, returns the epoch to retire it with
+	/// Readers pinning from now on get a later epoch and can only see what is published now
+	uint64_t advance() {
+		// the unpublishing store must be ordered before the scan of the records in safeEpoch
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return globalEpoch.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	/// Objects retired with an epoch below the result can be freed, no reader can reach them anymore
+	uint64_t safeEpoch() const {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		uint64_t result = globalEpoch.load(std::memory_order_acquire);
+		for (Record *record = records.load(std::memory_order_acquire); record; record = record->next) {
+			const uint64_t pinned = record->epoch.load(std::memory_order_acquire);
+			if (pinned != Quiescent && pinned < result) {
+				result = pinned;
+			}
+		}
+		return result;
+	}
+};
+
+/// Read section for the scope of the guard, see EpochDomain::pin
+class EpochGuard {
+	EpochDomain &domain;
+public:
+	explicit EpochGuard(EpochDomain &domain = EpochDomain::instance())
+		: domain(domain) {
+		domain.pin();
+	}
+
+	EpochGuard(const EpochGuard &) = delete;
+	EpochGuard & operator=(const EpochGuard &) = delete;
+
+	~EpochGuard() {
+		domain.unpin();
+	}
+};
@@ -0,0 +1,537 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "capacity-policy.hpp"
+#include "probers.hpp"
+
+/// Values of a flat table, kept in their own array parallel to the keys
+template <typename T>
+class FlatValues {
+	std::vector<T> values;
+public:
+	explicit FlatValues(size_t size = 0)
+		: values(size) {}
+
+	void swap(FlatValues &other) {
+		values.swap(other.values);
+	}
+
+	T & operator[](size_t idx) {
+		return values[idx];
+	}
+
+	template <typename ... Args>
+	void assign(size_t idx, Args && ... args) {
+		values[idx] = T(std::forward<Args>(args)...);
+	}
+
+	void moveFrom(size_t idx, FlatValues &other, size_t otherIdx) {
+		values[idx] = std::move(other.values[otherIdx]);
+	}
+};
+
+/// Sets have no values, the array and every operation on it compile to nothing
+template <>
+class FlatValues<void> {
+public:
+	explicit FlatValues(size_t = 0) {}
+
+	void swap(FlatValues &) {}
+
+	void assign(size_t) {}
+
+	void moveFrom(size_t, FlatValues &, size_t) {}
+};
+
+/// What flat table iterators point to, key and value references for maps
+/// Key and value are not adjacent in memory, so the pair is made on dereference and -> goes through a holder
+template <typename K, typename T>
+struct FlatElement {
+	typedef std::pair<const K &, T &> type;
+
+	struct pointer {
+		type element;
+
+		type * operator->() {
+			return &element;
+		}
+	};
+
+	static type make(const K &key, FlatValues<T> &values, size_t idx) {
+		return type(key, values[idx]);
+	}
+
+	static pointer address(const K &key, FlatValues<T> &values, size_t idx) {
+		return pointer{make(key, values, idx)};
+	}
+};
+
+/// Set iterators point to the key
+template <typename K>
+struct FlatElement<K, void> {
+	typedef const K & type;
+	typedef const K * pointer;
+
+	static type make(const K &key, FlatValues<void> &, size_t) {
+		return key;
+	}
+
+	static pointer address(const K &key, FlatValues<void> &, size_t) {
+		return &key;
+	}
+};
+
+/// Open addressing table with the bucket fields split into parallel arrays: one byte of state, the keys and the values
+/// Probing reads only the states and the keys, a value is touched on a hit, and no slot pays padding for the
+/// bool flags of OOHashTable::Bucket. T = void stores no values at all, see HashSet.
+/// Common part of FlatHashTable and HashSet, which add the map and set insert interfaces
+template <typename K, typename T, typename Hash, typename IndexProbe, typename Capacity>
+class FlatHashTableBase {
+	static_assert(ProbeCoverage<IndexProbe, Capacity>::value,
+		"IndexProbe does not reach every bucket with this Capacity, lookups could loop forever; specialize ProbeCoverage if it does");
+public:
+	typedef K key_type;
+protected:
+	enum State : uint8_t {
+		Empty, ///< Never used, ends the probe sequences
+		Full, ///< Holds an element
+		Deleted, ///< Element was removed, skipped by lookups and re-used by inserts
+	};
+
+	std::vector<uint8_t> states; ///< State of each bucket
+	std::vector<K> keys; ///< Key of each bucket, default constructed when not Full
+	FlatValues<T> values; ///< Value of each bucket, nothing for sets
+	size_t count; ///< Actual number of elements
+	size_t deletedCount; ///< Number of deleted buckets, they still lengthen the probe sequences
+	float maxLoad; ///< Resize when (count + deletedCount + 1) / buckets reaches this, must be below 1
+	Hash hasher; ///< The hash functor
+	IndexProbe nextIndex; ///< Functor to access next index
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+
+	size_t getIndex(size_t hash) const {
+		return sizePolicy.index(hash, states.size());
+	}
+
+	size_t getNextIndex(size_t index, size_t hash, size_t step) const {
+		return probeNext(nextIndex, index, states.size(), hash, step);
+	}
+
+	/// What the prober gets as the hash on every step of the probe sequence of hash, see probeStart
+	size_t getProbeHash(size_t hash) const {
+		return probeStart(nextIndex, states.size(), hash);
+	}
+
+	/// Deleted buckets and the bucket about to be filled count towards the load
+	/// so there is always an empty bucket to end the probing, even for a load factor close to 1
+	bool needsResize() const {
+		const float factor = float(count + deletedCount + 1) / states.size();
+		return factor >= maxLoad;
+	}
+
+	/// Called when the load is reached, if it is mostly deleted buckets re-hash to the same size to drop them
+	void resize() {
+		const bool mostlyDeleted = float(count) / states.size() < maxLoad / 2;
+		resize(mostlyDeleted ? states.size() : sizePolicy.grow(states.size()));
+	}
+
+	/// Re-hash the table into newSize buckets, keys and values are moved
+	void resize(size_t newSize) {
+		std::vector<uint8_t> oldStates(newSize, Empty);
+		std::vector<K> oldKeys(newSize);
+		FlatValues<T> oldValues(newSize);
+		// swap with members so findEmptyIndex works on the new arrays
+		oldStates.swap(states);
+		oldKeys.swap(keys);
+		oldValues.swap(values);
+
+		deletedCount = 0;
+		for (size_t c = 0; c < oldStates.size(); c++) {
+			if (oldStates[c] == Full) {
+				const size_t idx = findEmptyIndex(hasher(oldKeys[c]));
+				states[idx] = Full;
+				keys[idx] = std::move(oldKeys[c]);
+				values.moveFrom(idx, oldValues, c);
+			}
+		}
+	}
+
+	/// First empty bucket in the probe sequence of hash, only for tables without deleted buckets
+	size_t findEmptyIndex(size_t hash) const {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; states[idx] != Empty; step++) {
+			idx = getNextIndex(idx, probeHash, step);
+		}
+		return idx;
+	}
+
+	/// Index of the bucket holding key or bucket count if key is not in the table
+	size_t findIndex(const K &key) const {
+		const size_t hash = hasher(key);
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; ; step++) {
+			const uint8_t state = states[idx];
+			if (state == Empty) {
+				return states.size();
+			}
+			if (state == Full && keys[idx] == key) {
+				return idx;
+			}
+			idx = getNextIndex(idx, probeHash, step);
+		}
+	}
+
+	/// Walk the probe sequence once for a key that may be inserted
+	/// Returns the index of the key or bucket count if not present, in which case
+	/// freeIndex is set to the first deleted or empty bucket where the key can go
+	size_t findInsertIndex(const K &key, size_t hash, size_t &freeIndex) const {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		freeIndex = states.size();
+		for (size_t step = 1; ; step++) {
+			const uint8_t state = states[idx];
+			if (state != Full) {
+				if (freeIndex == states.size()) {
+					freeIndex = idx;
+				}
+				// only a never used bucket ends the probe sequence, the key could be after a deleted one
+				if (state == Empty) {
+					return states.size();
+				}
+			} else if (keys[idx] == key) {
+				return idx;
+			}
+			idx = getNextIndex(idx, probeHash, step);
+		}
+	}
+
+	/// Look up the key once and if not present put it in the first free bucket with a value constructed from args
+	/// Returns the bucket index and true if the key was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<size_t, bool> emplaceIndex(KeyArg &&key, Args && ... args) {
+		const size_t hash = hasher(key);
+		size_t freeIndex;
+		const size_t idx = findInsertIndex(key, hash, freeIndex);
+		if (idx != states.size()) {
+			return std::make_pair(idx, false);
+		}
+
+		// resize only when actually inserting, the new table has no deleted buckets
+		if (needsResize()) {
+			resize();
+			freeIndex = findEmptyIndex(hash);
+		}
+
+		if (states[freeIndex] == Deleted) {
+			--deletedCount;
+		}
+		++count;
+		states[freeIndex] = Full;
+		keys[freeIndex] = std::forward<KeyArg>(key);
+		values.assign(freeIndex, std::forward<Args>(args)...);
+		return std::make_pair(freeIndex, true);
+	}
+
+public:
+	FlatHashTableBase(Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: states(capacity.initial(32), Empty)
+		, keys(states.size())
+		, values(states.size())
+		, count(0)
+		, deletedCount(0)
+		, maxLoad(0.7f)
+		, hasher(hash)
+		, nextIndex(probe)
+		, sizePolicy(capacity) {}
+
+	/// Iterator over the elements, dereferences to a pair of key and value references for maps and to the key for sets
+	class iterator {
+		friend class FlatHashTableBase;
+		FlatHashTableBase *owner; ///< Pointer so the iterators can be easily copy-able
+		size_t idx; ///< Current bucket
+
+		iterator(FlatHashTableBase &owner, size_t idx)
+			: owner(&owner)
+			, idx(idx)
+		{
+			validateIterator();
+		}
+
+		/// Skip empty and deleted buckets
+		void validateIterator() {
+			while (idx < owner->states.size() && owner->states[idx] != Full) {
+				++idx;
+			}
+		}
+	public:
+		typedef typename FlatElement<K, T>::type reference;
+		typedef typename FlatElement<K, T>::pointer pointer;
+
+		reference operator*() const {
+			return FlatElement<K, T>::make(owner->keys[idx], owner->values, idx);
+		}
+
+		pointer operator->() const {
+			return FlatElement<K, T>::address(owner->keys[idx], owner->values, idx);
+		}
+
+		iterator& operator++() {
+			++idx;
+			validateIterator();
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		bool operator==(const iterator &other) const {
+			return owner == other.owner && idx == other.idx;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	iterator begin() {
+		return iterator(*this, 0);
+	}
+
+	iterator end() {
+		return iterator(*this, states.size());
+	}
+
+protected:
+	/// Iterator for the derived tables, which can not use the private constructor
+	iterator iteratorAt(size_t idx) {
+		return iterator(*this, idx);
+	}
+
+public:
+	/// Get iterator for a given key or end() if key is not inserted
+	iterator find(const K &key) {
+		return iterator(*this, findIndex(key));
+	}
+
+	bool contains(const K &key) const {
+		return findIndex(key) != states.size();
+	}
+
+	/// Erase an item and return iterator to the next valid item or end()
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+		assert(states[it.idx] == Full);
+		states[it.idx] = Deleted;
+		// release whatever the key and value hold now, not when the bucket is re-used
+		keys[it.idx] = K();
+		values.assign(it.idx);
+		--count;
+		++deletedCount;
+		it.validateIterator();
+		return it;
+	}
+
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Remove all elements and release the keys and values with the arrays, the table goes back to its initial size
+	void clear() {
+		std::vector<uint8_t>(sizePolicy.initial(32), Empty).swap(states);
+		std::vector<K>(states.size()).swap(keys);
+		FlatValues<T>(states.size()).swap(values);
+		count = 0;
+		deletedCount = 0;
+	}
+
+	/// Number of buckets in the table
+	size_t bucket_count() const {
+		return states.size();
+	}
+
+	float max_load_factor() const {
+		return maxLoad;
+	}
+
+	/// Set the load factor at which the table grows, rehashes now if it is already reached
+	void max_load_factor(float factor) {
+		assert(factor > 0 && factor < 1);
+		maxLoad = factor;
+		if (needsResize()) {
+			rehash(0);
+		}
+	}
+
+	/// Set the bucket count to at least buckets and enough for size() elements, drops deleted buckets
+	void rehash(size_t buckets) {
+		// + 1 so the load is strictly below maxLoad and there is room for one insert
+		const size_t needed = std::max(buckets, bucketsForCount(count + 1, maxLoad));
+		resize(sizePolicy.initial(needed));
+	}
+
+	/// Make room for elementCount elements so inserting up to that many does not resize
+	void reserve(size_t elementCount) {
+		const size_t needed = bucketsForCount(elementCount + 1, maxLoad);
+		if (needed > states.size()) {
+			rehash(needed);
+		}
+	}
+
+	/// Get the number of elements
+	size_t size() const {
+		return count;
+	}
+};
+
+/// Flat map with keys and values in separate arrays, same interface as OOHashTable
+/// Iterators dereference to std::pair<const K &, T &> instead of a reference to a stored pair
+template <typename K, typename T, typename Hash = std::hash<K>, typename IndexProbe = LinearProber, typename Capacity = PowerOfTwoCapacity>
+class FlatHashTable : public FlatHashTableBase<K, T, Hash, IndexProbe, Capacity> {
+	typedef FlatHashTableBase<K, T, Hash, IndexProbe, Capacity> base;
+public:
+	typedef typename base::iterator iterator;
+	typedef std::pair<K, T> pair_type;
+	typedef T value_type;
+	typedef value_type & reference;
+
+	using base::base;
+
+	/// Construct from a range of key-value pairs, for duplicate keys the first one is kept
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	FlatHashTable(InputIt first, InputIt last, Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: base(hash, probe, capacity) {
+		insert(first, last);
+	}
+
+private:
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		const std::pair<size_t, bool> result = this->emplaceIndex(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+		return std::make_pair(this->iteratorAt(result.first), result.second);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		const std::pair<size_t, bool> result = this->emplaceIndex(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			this->values[result.first] = std::forward<Value>(value);
+		}
+		return std::make_pair(this->iteratorAt(result.first), result.second);
+	}
+
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
+
+	/// Insert a range of key-value pairs without overwriting existing keys, reserves space once for forward ranges
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		this->reserve(this->count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			tryEmplace(first->first, first->second);
+		}
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value from args, otherwise do nothing
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
+	}
+
+	/// Get reference to a value based on a key, if not present insert default constructed value
+	T & operator[](const K &key) {
+		return this->values[this->emplaceIndex(key).first];
+	}
+
+	T & operator[](K &&key) {
+		return this->values[this->emplaceIndex(std::move(key)).first];
+	}
+};
+
+/// Set of keys without any value storage, one state byte and one key per bucket
+/// Iterators dereference to const K &
+template <typename K, typename Hash = std::hash<K>, typename IndexProbe = LinearProber, typename Capacity = PowerOfTwoCapacity>
+class HashSet : public FlatHashTableBase<K, void, Hash, IndexProbe, Capacity> {
+	typedef FlatHashTableBase<K, void, Hash, IndexProbe, Capacity> base;
+public:
+	typedef typename base::iterator iterator;
+	typedef K value_type;
+
+	using base::base;
+
+	/// Construct from a range of keys
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	HashSet(InputIt first, InputIt last, Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: base(hash, probe, capacity) {
+		insert(first, last);
+	}
+
+	/// Insert key if not present, returns iterator to it and true if it was inserted
+	std::pair<iterator, bool> insert(const K &key) {
+		const std::pair<size_t, bool> result = this->emplaceIndex(key);
+		return std::make_pair(this->iteratorAt(result.first), result.second);
+	}
+
+	std::pair<iterator, bool> insert(K &&key) {
+		const std::pair<size_t, bool> result = this->emplaceIndex(std::move(key));
+		return std::make_pair(this->iteratorAt(result.first), result.second);
+	}
+
+	/// Insert a range of keys, reserves space once for forward ranges
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		this->reserve(this->count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			this->emplaceIndex(*first);
+		}
+	}
+
+	/// Construct a key from args and insert it if not present
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		return insert(K(std::forward<Args>(args)...));
+	}
+};
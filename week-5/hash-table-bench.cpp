@@ -0,0 +1,504 @@
+#include "co-hash-table.hpp"
+#include "oo-hash-table.hpp"
+#include "swiss-hash-table.hpp"
+#include "robin-hood-hash-table.hpp"
+#include "pool-hash-table.hpp"
+#include "cuckoo-hash-table.hpp"
+#include "flat-hash-table.hpp"
+#include "compact-hash-table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+/// Tables using power of two capacity, aliased so they can be passed as template template parameters
+template <typename K, typename T>
+using PowerOfTwoCOHashTable = COHashTable<K, T, std::hash<K>, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using PowerOfTwoOOHashTable = OOHashTable<K, T, std::hash<K>, LinearProber, PowerOfTwoCapacity>;
+
+/// Tables keeping the hash of each key
+template <typename K, typename T>
+using StoredHashCOHashTable = COHashTable<K, T, std::hash<K>, ModuloCapacity, StoredHash>;
+
+template <typename K, typename T>
+using StoredHashOOHashTable = OOHashTable<K, T, std::hash<K>, LinearProber, PowerOfTwoCapacity, StoredHash>;
+
+/// Open addressing with the other probers
+template <typename K, typename T>
+using QuadraticOOHashTable = OOHashTable<K, T, std::hash<K>, QuadraticProber, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using DoubleHashOOHashTable = OOHashTable<K, T, std::hash<K>, DoubleHashProber, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using PrimeDoubleHashOOHashTable = OOHashTable<K, T, std::hash<K>, DoubleHashProber, PrimeCapacity>;
+
+/// Tables with the FastHash family instead of std::hash
+template <typename K, typename T>
+using FastHashCOHashTable = COHashTable<K, T, FastHash<K>>;
+
+template <typename K, typename T>
+using FastHashOOHashTable = OOHashTable<K, T, FastHash<K>, LinearProber, PowerOfTwoCapacity>;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/// Every sampleEvery-th operation is timed on its own for the latency percentiles
+const size_t sampleEvery = 32;
+
+/// Sink for results of lookups so they are not optimized out
+volatile long long benchSink;
+
+/// Process memory in bytes, current is 0 where it can not be read
+struct MemoryUsage {
+	size_t current;
+	size_t peak;
+};
+
+MemoryUsage memoryUsage() {
+	MemoryUsage usage = {0, 0};
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		usage.current = counters.WorkingSetSize;
+		usage.peak = counters.PeakWorkingSetSize;
+	}
+#else
+	rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0) {
+		// kilobytes on Linux
+		usage.peak = size_t(ru.ru_maxrss) * 1024;
+	}
+	if (FILE *statm = fopen("/proc/self/statm", "r")) {
+		unsigned long pages, resident;
+		if (fscanf(statm, "%lu %lu", &pages, &resident) == 2) {
+			usage.current = size_t(resident) * size_t(sysconf(_SC_PAGESIZE));
+		}
+		fclose(statm);
+	}
+#endif
+	return usage;
+}
+
+/// Zipf distributed ranks in [0, n), rank 0 is the most frequent
+/// Uses the constant time method from Gray et al. "Quickly generating billion-record synthetic databases",
+/// only the construction is O(n)
+class ZipfGenerator {
+	size_t n;
+	double theta, alpha, zetan, eta;
+public:
+	ZipfGenerator(size_t n, double theta)
+		: n(n)
+		, theta(theta)
+		, alpha(1.0 / (1.0 - theta))
+		, zetan(0) {
+		for (size_t c = 1; c <= n; c++) {
+			zetan += 1.0 / std::pow(double(c), theta);
+		}
+		const double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+		eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+	}
+
+	template <typename Rng>
+	size_t operator()(Rng &rng) {
+		const double u = std::uniform_real_distribution<double>(0, 1)(rng);
+		const double uz = u * zetan;
+		if (uz < 1.0) {
+			return 0;
+		}
+		if (uz < 1.0 + std::pow(0.5, theta)) {
+			return 1;
+		}
+		return std::min(n - 1, size_t(n * std::pow(eta * u - eta + 1.0, alpha)));
+	}
+};
+
+/// Bijective 32 bit mixer (murmur3 finalizer), distinct inputs give distinct keys in random order
+uint32_t mixKey(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85EBCA6Bu;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return x;
+}
+
+/// Sequential keys are idx itself, like ids from a counter, the others are spread over the whole range
+void makeKey(uint32_t idx, bool sequential, int &key) {
+	key = int(sequential ? idx : mixKey(idx));
+}
+
+void makeKey(uint32_t idx, bool sequential, std::string &key) {
+	// 20 characters, past the small string buffer of the common standard libraries
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "session-%012u", sequential ? idx : mixKey(idx));
+	key = buffer;
+}
+
+/// Keys for one size: the first half is inserted, the second half is never present before churn
+template <typename K>
+std::vector<K> makeKeys(size_t size, bool sequential) {
+	std::vector<K> keys(size * 2);
+	for (size_t c = 0; c < keys.size(); c++) {
+		makeKey(uint32_t(c), sequential, keys[c]);
+	}
+	return keys;
+}
+
+/// Sequence of key indices in [0, size) for the lookup workloads
+struct Distribution {
+	const char *name;
+	std::vector<uint32_t> indices;
+};
+
+/// One row of the output
+struct Result {
+	const char *table;
+	const char *key;
+	size_t size;
+	float loadFactor;
+	const char *distribution;
+	const char *workload;
+	size_t ops;
+	double seconds;
+	double p50, p90, p99, p999; ///< Latency percentiles in nanoseconds
+	MemoryUsage memory;
+};
+
+/// Collects timings of one workload
+class Measure {
+	std::vector<double> samples; ///< Latencies of the sampled operations in nanoseconds
+	double clockOverhead; ///< Cost of reading the clock twice, subtracted from each sample
+	double percentile(double p) {
+		if (samples.empty()) {
+			return 0;
+		}
+		const size_t idx = std::min(samples.size() - 1, size_t(p * samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+		return samples[idx];
+	}
+public:
+	explicit Measure(double clockOverhead)
+		: clockOverhead(clockOverhead) {}
+
+	/// Call op(c) for c in [0, ops) and fill the timings of result
+	template <typename Op>
+	void run(size_t ops, Result &result, Op op) {
+		samples.clear();
+		samples.reserve(ops / sampleEvery + 1);
+
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t c = 0; c < ops; c++) {
+			if (c % sampleEvery == 0) {
+				const bench_clock::time_point opStart = bench_clock::now();
+				op(c);
+				const std::chrono::duration<double, std::nano> took = bench_clock::now() - opStart;
+				samples.push_back(std::max(0.0, took.count() - clockOverhead));
+			} else {
+				op(c);
+			}
+		}
+		const std::chrono::duration<double> elapsed = bench_clock::now() - start;
+
+		result.ops = ops;
+		result.seconds = elapsed.count();
+		result.p50 = percentile(0.5);
+		result.p90 = percentile(0.9);
+		result.p99 = percentile(0.99);
+		result.p999 = percentile(0.999);
+		result.memory = memoryUsage();
+	}
+};
+
+/// Median cost of two back to back clock reads in nanoseconds
+double measureClockOverhead() {
+	std::vector<double> samples(1001);
+	for (double &sample : samples) {
+		const bench_clock::time_point start = bench_clock::now();
+		const std::chrono::duration<double, std::nano> took = bench_clock::now() - start;
+		sample = took.count();
+	}
+	std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+	return samples[samples.size() / 2];
+}
+
+/// Prints results as CSV or as a JSON array
+class Output {
+	bool json;
+	bool first;
+public:
+	explicit Output(bool json)
+		: json(json)
+		, first(true) {
+		if (json) {
+			puts("[");
+		} else {
+			puts("table,key,size,load_factor,distribution,workload,ops,seconds,mops,p50_ns,p90_ns,p99_ns,p999_ns,rss_mb,peak_rss_mb");
+		}
+	}
+
+	~Output() {
+		if (json) {
+			puts("\n]");
+		}
+	}
+
+	void print(const Result &r) {
+		const double mops = r.ops / r.seconds / 1e6;
+		const double mb = 1024 * 1024;
+		if (json) {
+			printf("%s  {\"table\": \"%s\", \"key\": \"%s\", \"size\": %zu, \"load_factor\": %.2f, \"distribution\": \"%s\", "
+				"\"workload\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, \"mops\": %.3f, "
+				"\"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f, \"rss_mb\": %.1f, \"peak_rss_mb\": %.1f}",
+				first ? "" : ",\n", r.table, r.key, r.size, r.loadFactor, r.distribution,
+				r.workload, r.ops, r.seconds, mops,
+				r.p50, r.p90, r.p99, r.p999, r.memory.current / mb, r.memory.peak / mb);
+		} else {
+			printf("%s,%s,%zu,%.2f,%s,%s,%zu,%.6f,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+				r.table, r.key, r.size, r.loadFactor, r.distribution,
+				r.workload, r.ops, r.seconds, mops,
+				r.p50, r.p90, r.p99, r.p999, r.memory.current / mb, r.memory.peak / mb);
+		}
+		fflush(stdout);
+		first = false;
+	}
+};
+
+/// Everything shared by the runs of one size
+template <typename K>
+struct Workload {
+	const char *keyName;
+	size_t size; ///< Number of elements in the table
+	size_t minOps; ///< Lookup, iteration and churn workloads repeat up to at least this many operations
+	const std::vector<K> &keys; ///< 2 * size keys, see makeKeys
+	const std::vector<Distribution> &distributions; ///< Indices of the keys for find-hit
+};
+
+/// Insert with try_emplace, or with insert for tables without it, the keys are never present so insert does not overwrite
+template <typename Table, typename K>
+auto emplaceKey(Table &table, const K &key, int value, int) -> decltype(void(table.try_emplace(key, value))) {
+	table.try_emplace(key, value);
+}
+
+template <typename Table, typename K>
+void emplaceKey(Table &table, const K &key, int value, long) {
+	table.insert(key, value);
+}
+
+/// Set the max load factor, tables without one grow at their own fixed load, see runFixedLoad
+template <typename Table>
+auto setMaxLoad(Table &table, float loadFactor, int) -> decltype(void(table.max_load_factor(loadFactor))) {
+	table.max_load_factor(loadFactor);
+}
+
+template <typename Table>
+void setMaxLoad(Table &, float, long) {}
+
+/// Run all workloads on one table type with one load factor
+/// The table needs find, erase, iteration and insert or try_emplace, max_load_factor is used if it has one
+template <typename Table, typename K>
+void runTable(const char *tableName, float loadFactor, const Workload<K> &w, Measure &measure, Output &output) {
+	Result result = {};
+	result.table = tableName;
+	result.key = w.keyName;
+	result.size = w.size;
+	result.loadFactor = loadFactor;
+	result.distribution = "uniform";
+
+	const K *keys = w.keys.data();
+	const size_t size = w.size;
+	const size_t repeatedOps = std::max(size, w.minOps);
+
+	// small tables are filled several times so the insert time is measurable, all are created before timing
+	const size_t rounds = std::max<size_t>(1, w.minOps / size);
+	std::vector<Table> tables(rounds);
+	for (Table &table : tables) {
+		setMaxLoad(table, loadFactor, 0);
+	}
+	result.workload = "insert";
+	measure.run(rounds * size, result, [&](size_t c) {
+		emplaceKey(tables[c / size], keys[c % size], int(c), 0);
+	});
+	output.print(result);
+
+	// the rest of the workloads use the last table
+	Table table(std::move(tables.back()));
+	std::vector<Table>().swap(tables);
+
+	for (const Distribution &distribution : w.distributions) {
+		const uint32_t *indices = distribution.indices.data();
+		result.workload = "find-hit";
+		result.distribution = distribution.name;
+		long long found = 0;
+		measure.run(repeatedOps, result, [&](size_t c) {
+			found += table.find(keys[indices[c]]) != table.end();
+		});
+		benchSink = found;
+		output.print(result);
+	}
+	result.distribution = "uniform";
+
+	result.workload = "find-miss";
+	long long found = 0;
+	measure.run(repeatedOps, result, [&](size_t c) {
+		found += table.find(keys[size + c % size]) != table.end();
+	});
+	benchSink = found;
+	output.print(result);
+
+	// one operation is visiting one element, there are no latency percentiles as elements are not timed one by one
+	result.workload = "iteration";
+	const size_t passes = repeatedOps / size;
+	long long sum = 0;
+	const bench_clock::time_point start = bench_clock::now();
+	for (size_t pass = 0; pass < passes; pass++) {
+		for (const auto &element : table) {
+			sum += element.second;
+		}
+	}
+	const std::chrono::duration<double> elapsed = bench_clock::now() - start;
+	benchSink = sum;
+	result.ops = passes * size;
+	result.seconds = elapsed.count();
+	result.p50 = result.p90 = result.p99 = result.p999 = 0;
+	result.memory = memoryUsage();
+	output.print(result);
+
+	// each operation erases one key and inserts another, moving between the two halves of keys on every pass
+	result.workload = "churn";
+	measure.run(passes * size, result, [&](size_t c) {
+		const size_t idx = c % size;
+		const bool even = (c / size) % 2 == 0;
+		table.erase(keys[even ? idx : size + idx]);
+		emplaceKey(table, keys[even ? size + idx : idx], int(c), 0);
+	});
+	output.print(result);
+
+	// two thirds of the keys are erased, leaving the table at about a third of its load for a sparse iteration
+	const size_t present = passes % 2 == 0 ? 0 : size;
+	const size_t erased = size - size / 3;
+	result.workload = "erase";
+	measure.run(erased, result, [&](size_t c) {
+		table.erase(keys[present + c]);
+	});
+	output.print(result);
+
+	result.workload = "iteration-sparse";
+	const size_t remaining = size - erased;
+	const size_t sparsePasses = std::max<size_t>(1, repeatedOps / std::max<size_t>(1, remaining));
+	sum = 0;
+	const bench_clock::time_point sparseStart = bench_clock::now();
+	for (size_t pass = 0; pass < sparsePasses; pass++) {
+		for (const auto &element : table) {
+			sum += element.second;
+		}
+	}
+	const std::chrono::duration<double> sparseElapsed = bench_clock::now() - sparseStart;
+	benchSink = sum;
+	result.ops = sparsePasses * remaining;
+	result.seconds = sparseElapsed.count();
+	result.p50 = result.p90 = result.p99 = result.p999 = 0;
+	result.memory = memoryUsage();
+	output.print(result);
+}
+
+/// Run every load factor for one table template with one key type
+template <template <typename ...> class HashTable, typename K>
+void runLoadFactors(const char *tableName, const char *filter, const Workload<K> &w, Measure &measure, Output &output) {
+	if (filter && !strstr(tableName, filter)) {
+		return;
+	}
+	// 0.95 is where linear probing degrades and cuckoo hashing still has bounded lookups
+	const float loadFactors[] = {0.5f, 0.7f, 0.9f, 0.95f};
+	for (float loadFactor : loadFactors) {
+		fprintf(stderr, "%s %s %zu %.2f\n", tableName, w.keyName, w.size, loadFactor);
+		runTable<HashTable<K, int>>(tableName, loadFactor, w, measure, output);
+	}
+}
+
+/// Run a table that has no max_load_factor once, loadFactor is the load it grows at and is only reported
+template <template <typename ...> class HashTable, typename K>
+void runFixedLoad(const char *tableName, float loadFactor, const char *filter, const Workload<K> &w, Measure &measure, Output &output) {
+	if (filter && !strstr(tableName, filter)) {
+		return;
+	}
+	fprintf(stderr, "%s %s %zu %.2f\n", tableName, w.keyName, w.size, loadFactor);
+	runTable<HashTable<K, int>>(tableName, loadFactor, w, measure, output);
+}
+
+template <typename K>
+void runSize(const char *keyName, bool sequential, size_t size, size_t minOps, const char *filter, Measure &measure, Output &output) {
+	const std::vector<K> keys = makeKeys<K>(size, sequential);
+
+	const size_t ops = std::max(size, minOps);
+	std::mt19937_64 rng(size);
+	std::vector<Distribution> distributions(2);
+	distributions[0].name = "uniform";
+	distributions[1].name = "zipf";
+	std::uniform_int_distribution<size_t> uniform(0, size - 1);
+	ZipfGenerator zipf(size, 0.99);
+	for (size_t c = 0; c < ops; c++) {
+		distributions[0].indices.push_back(uint32_t(uniform(rng)));
+		distributions[1].indices.push_back(uint32_t(zipf(rng)));
+	}
+
+	const Workload<K> w = {keyName, size, minOps, keys, distributions};
+	runLoadFactors<COHashTable>("co", filter, w, measure, output);
+	runLoadFactors<OOHashTable>("oo", filter, w, measure, output);
+	runLoadFactors<PowerOfTwoCOHashTable>("co-pow2", filter, w, measure, output);
+	runLoadFactors<PowerOfTwoOOHashTable>("oo-pow2", filter, w, measure, output);
+	runLoadFactors<StoredHashCOHashTable>("co-stored", filter, w, measure, output);
+	runLoadFactors<StoredHashOOHashTable>("oo-pow2-stored", filter, w, measure, output);
+	runLoadFactors<QuadraticOOHashTable>("oo-pow2-quadratic", filter, w, measure, output);
+	runLoadFactors<DoubleHashOOHashTable>("oo-pow2-double", filter, w, measure, output);
+	runLoadFactors<PrimeDoubleHashOOHashTable>("oo-prime-double", filter, w, measure, output);
+	runLoadFactors<FastHashCOHashTable>("co-fasthash", filter, w, measure, output);
+	runLoadFactors<FastHashOOHashTable>("oo-pow2-fasthash", filter, w, measure, output);
+	runLoadFactors<CuckooHashTable>("cuckoo", filter, w, measure, output);
+	runLoadFactors<FlatHashTable>("flat", filter, w, measure, output);
+	runLoadFactors<CompactHashTable>("compact", filter, w, measure, output);
+	runFixedLoad<SwissHashTable>("swiss", 0.875f, filter, w, measure, output);
+	runFixedLoad<RobinHoodHashTable>("robin-hood", 0.9f, filter, w, measure, output);
+	runFixedLoad<PoolHashTable>("pool", 1.0f, filter, w, measure, output);
+	runLoadFactors<std::unordered_map>("std", filter, w, measure, output);
+}
+
+/// Usage: hash-table-bench [maxSize] [csv|json] [minOps] [tableFilter]
+/// Runs sizes 1K, 10K, ... up to maxSize with random int, sequential int and string keys, results go to stdout, progress to stderr.
+/// Peak RSS is for the whole process, run a single size and table (maxSize and tableFilter) to get the peak of one configuration.
+int main(int argc, char *argv[]) {
+	const size_t maxSize = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+	const bool json = argc > 2 && !strcmp(argv[2], "json");
+	const size_t minOps = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+	const char *filter = argc > 4 ? argv[4] : nullptr;
+
+	Measure measure(measureClockOverhead());
+	Output output(json);
+	for (size_t size = 1000; size <= maxSize; size *= 10) {
+		runSize<int>("int", false, size, minOps, filter, measure, output);
+		runSize<int>("seq-int", true, size, minOps, filter, measure, output);
+		runSize<std::string>("string", false, size, minOps, filter, measure, output);
+	}
+
+	return 0;
+}
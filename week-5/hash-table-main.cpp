@@ -1,9 +1,91 @@
 
 #include "oo-hash-table.hpp"
 #include "co-hash-table.hpp"
+#include "swiss-hash-table.hpp"
+#include "robin-hood-hash-table.hpp"
+#include "concurrent-hash-table.hpp"
+#include "lock-free-hash-table.hpp"
+#include "pool-hash-table.hpp"
+#include "mapped-oo-hash-table.hpp"
+#include "cuckoo-hash-table.hpp"
+#include "flat-hash-table.hpp"
+#include "small-hash-table.hpp"
+#include "huge-page-allocator.hpp"
+#include "compact-hash-table.hpp"
+#include "rcu-hash-table.hpp"
+#include "lru-cache.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <unordered_set>
+
+/// Tables using power of two capacity, aliased so they can be passed to testTable
+template <typename K, typename T>
+using PowerOfTwoCOHashTable = COHashTable<K, T, std::hash<K>, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using PowerOfTwoOOHashTable = OOHashTable<K, T, std::hash<K>, LinearProber, PowerOfTwoCapacity>;
+
+/// Open addressing with the other probers, paired with the capacity policies they cover fully
+template <typename K, typename T, typename Hash = std::hash<K>>
+using QuadraticOOHashTable = OOHashTable<K, T, Hash, QuadraticProber, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using DoubleHashOOHashTable = OOHashTable<K, T, std::hash<K>, DoubleHashProber, PowerOfTwoCapacity>;
+
+template <typename K, typename T>
+using PrimeDoubleHashOOHashTable = OOHashTable<K, T, std::hash<K>, DoubleHashProber, PrimeCapacity>;
+
+template <typename K, typename T>
+using PrimeCOHashTable = COHashTable<K, T, std::hash<K>, PrimeCapacity>;
+
+// triangular numbers modulo a prime reach only about half of the buckets
+static_assert(!ProbeCoverage<QuadraticProber, PrimeCapacity>::value, "Quadratic probing does not cover prime sizes");
+static_assert(!ProbeCoverage<DoubleHashProber, ModuloCapacity>::value, "Strides can share factors with odd sizes");
+
+/// Tables keeping the hash of each key, so rehash does not call the hasher and keys are compared only on equal hashes
+template <typename K, typename T, typename Hash = std::hash<K>>
+using StoredHashCOHashTable = COHashTable<K, T, Hash, ModuloCapacity, StoredHash>;
+
+template <typename K, typename T, typename Hash = std::hash<K>>
+using StoredHashOOHashTable = OOHashTable<K, T, Hash, LinearProber, PowerOfTwoCapacity, StoredHash>;
+
+/// Tables with the fast hasher family, the modulo one checks that sequential and strided keys spread without the identity hash
+template <typename K, typename T>
+using FastHashCOHashTable = COHashTable<K, T, FastHash<K>>;
+
+template <typename K, typename T>
+using FastHashOOHashTable = OOHashTable<K, T, FastHash<K>, LinearProber, PowerOfTwoCapacity>;
+
+/// Inline storage for up to 8 elements in front of each table type
+template <typename K, typename T>
+using SmallCOHashTable = SmallHashTable<K, T, 8, COHashTable<K, T>>;
+
+template <typename K, typename T>
+using SmallOOHashTable = SmallHashTable<K, T, 8, OOHashTable<K, T>>;
+
+/// Bucket arrays of 1 MiB and more on huge pages, so testTable crosses the threshold while growing
+template <typename K, typename T>
+using HugePageOOHashTable = OOHashTable<K, T, std::hash<K>, LinearProber, PowerOfTwoCapacity, NoStoredHash, HugePageAllocator<std::pair<K, T>, 1 << 20>>;
+
+/// Closed addressing table rehashing one bucket per operation, so the tests run with a rehash in progress most of the time
+template <typename K, typename T, typename Hash = std::hash<K>>
+struct IncrementalCOHashTable : COHashTable<K, T, Hash> {
+	using COHashTable<K, T, Hash>::COHashTable;
+
+	IncrementalCOHashTable() {
+		this->setIncrementalRehash(1);
+	}
+};
 
 /// accept any container with typename templates
 /// function will work correctly only if HashTable is actually a key-value associative container
@@ -29,7 +111,7 @@ void testTable() {
 		for (int c = start; c < mapSize; c++) {
 			if (c % 2) {
 				ht.insert(c, c + 1);
-				assert(ht.size() == c + 1);
+				assert(ht.size() == size_t(c + 1));
 				assert(ht[c] == c + 1);
 			} else {
 				ht[c] = c + 1;
@@ -141,6 +223,1096 @@ void testTable() {
 
 		assert(stdMap.size() == ht.size());
 	}
+
+	{
+		puts("testing insert/erase churn");
+		IntHashT ht;
+		// keep a small window of live keys while many distinct keys pass through the table
+		const int live = 100;
+		const int total = mapSize * 10;
+		for (int c = 0; c < total; c++) {
+			ht.insert(c, c + 1);
+			if (c >= live) {
+				ht.erase(c - live);
+			}
+			assert(ht.size() == size_t(c < live ? c + 1 : live));
+		}
+
+		for (int c = 0; c < total; c++) {
+			ht_int_iterator p = ht.find(c);
+			if (c < total - live) {
+				assert(p == ht.end());
+			} else {
+				assert(p != ht.end());
+				assert(p->second == c + 1);
+			}
+		}
+	}
+}
+
+/// Check emplace, try_emplace, insert_or_assign and move only values
+template <template <typename ...> class HashTable>
+void testEmplace() {
+	typedef HashTable<std::string, std::string> StringHashT;
+	typedef HashTable<int, std::unique_ptr<int>> UniqueHashT;
+
+	puts("testing emplace");
+	{
+		StringHashT ht;
+		std::pair<typename StringHashT::iterator, bool> result = ht.try_emplace("key", 3, 'a');
+		assert(result.second);
+		assert(result.first->second == "aaa");
+
+		// try_emplace and emplace never overwrite
+		result = ht.try_emplace("key", "bbb");
+		assert(!result.second);
+		assert(result.first->second == "aaa");
+		result = ht.emplace("key", "bbb");
+		assert(!result.second);
+		assert(ht.find("key")->second == "aaa");
+
+		result = ht.insert_or_assign("key", "ccc");
+		assert(!result.second);
+		assert(result.first->second == "ccc");
+		result = ht.insert_or_assign("other", "ddd");
+		assert(result.second);
+		assert(ht.size() == 2);
+
+		// rvalue overloads
+		std::string key(100, 'k'), value(100, 'v');
+		ht.insert(std::move(key), std::move(value));
+		assert(ht.find(std::string(100, 'k'))->second == std::string(100, 'v'));
+		ht[std::string(50, 'k')] = "eee";
+		assert(ht.find(std::string(50, 'k'))->second == "eee");
+		assert(ht.size() == 4);
+	}
+
+	{
+		UniqueHashT ht;
+		const int count = 1000;
+		for (int c = 0; c < count; c++) {
+			ht.try_emplace(c, new int(c));
+		}
+		for (int c = 0; c < count; c++) {
+			ht[c + count].reset(new int(c + count));
+		}
+		for (int c = 0; c < count * 2; c++) {
+			assert(*ht.find(c)->second == c);
+		}
+		assert(ht.size() == count * 2);
+	}
+}
+
+/// Check reserve, rehash, max_load_factor and construction from a range
+template <template <typename ...> class HashTable>
+void testReserve() {
+	typedef HashTable<int, int> IntHashT;
+
+	puts("testing reserve");
+	const int count = 10000;
+	{
+		IntHashT ht;
+		ht.reserve(count);
+		const size_t buckets = ht.bucket_count();
+		assert(float(count) / buckets <= ht.max_load_factor());
+		for (int c = 0; c < count; c++) {
+			ht.insert(c, c);
+		}
+		// no resize while filling the reserved space
+		assert(ht.bucket_count() == buckets);
+		assert(ht.size() == count);
+
+		// shrinks down to what the elements need
+		ht.rehash(0);
+		assert(ht.bucket_count() <= buckets);
+		for (int c = 0; c < count; c++) {
+			assert(ht.find(c)->second == c);
+		}
+	}
+
+	{
+		IntHashT ht;
+		ht.max_load_factor(0.25f);
+		for (int c = 0; c < count; c++) {
+			ht[c] = c;
+		}
+		assert(float(ht.size()) / ht.bucket_count() <= 0.25f);
+
+		// raising the limit does not rehash, lowering it below the current load does
+		ht.max_load_factor(0.5f);
+		const size_t buckets = ht.bucket_count();
+		ht.max_load_factor(0.1f);
+		assert(ht.bucket_count() > buckets);
+		assert(float(ht.size()) / ht.bucket_count() <= 0.1f);
+		for (int c = 0; c < count; c++) {
+			assert(ht.find(c)->second == c);
+		}
+	}
+
+	{
+		// a limit close to 1 still leaves an empty bucket at every size, so lookups of missing keys terminate
+		IntHashT ht;
+		ht.max_load_factor(0.99f);
+		for (int c = 0; c < count; c++) {
+			ht.insert(c, c);
+			assert(ht.find(-1 - c) == ht.end());
+		}
+		for (int c = 0; c < count; c += 2) {
+			ht.erase(c);
+			assert(ht.find(c) == ht.end());
+		}
+		for (int c = count; c < count * 2; c++) {
+			ht.insert(c, c);
+			assert(ht.find(-1 - c) == ht.end());
+		}
+		assert(ht.size() == count / 2 + count);
+	}
+
+	{
+		std::vector<std::pair<int, int>> pairs;
+		for (int c = 0; c < count; c++) {
+			pairs.emplace_back(c, c);
+		}
+		// duplicates keep the first value
+		pairs.emplace_back(0, -1);
+
+		IntHashT ht(pairs.begin(), pairs.end());
+		assert(ht.size() == count);
+		assert(ht.find(0)->second == 0);
+		assert(ht.find(count - 1)->second == count - 1);
+
+		std::vector<std::pair<int, int>> more = {{count, count}, {count + 1, count + 1}, {1, -1}};
+		ht.insert(more.begin(), more.end());
+		assert(ht.size() == count + 2);
+		assert(ht.find(count + 1)->second == count + 1);
+		assert(ht.find(1)->second == 1);
+	}
+}
+
+/// Check lookups with std::string_view and C strings through a transparent hasher
+/// std::string_view does not convert implicitly to std::string, so these only compile without a temporary key
+template <template <typename ...> class HashTable>
+void testTransparent() {
+	typedef HashTable<std::string, int, StringHash> StringHashT;
+
+	puts("testing heterogeneous lookup");
+	StringHashT ht;
+	const int count = 1000;
+	for (int c = 0; c < count; c++) {
+		ht[std::to_string(c)] = c;
+	}
+
+	for (int c = 0; c < count; c++) {
+		const std::string key = std::to_string(c);
+		const std::string_view view(key);
+		assert(ht.find(view) != ht.end());
+		assert(ht.find(view)->second == c);
+		assert(ht.contains(view));
+		assert(ht.contains(key.c_str()));
+	}
+
+	const char buffer[] = "123 456";
+	assert(ht.find(std::string_view(buffer, 3))->second == 123);
+	assert(!ht.contains(std::string_view(buffer)));
+	assert(ht.find(std::string_view(buffer)) == ht.end());
+
+	ht.erase(std::string_view(buffer + 4, 3));
+	assert(!ht.contains("456"));
+	assert(ht.size() == count - 1);
+}
+
+/// Hasher putting every key in the same bucket, the worst case stats() should catch
+struct ConstantHash {
+	size_t operator()(int) const {
+		return 42;
+	}
+};
+
+/// Check the counts in stats() and that a degenerate hasher shows up in the histograms
+template <template <typename ...> class HashTable>
+void testStats() {
+	typedef HashTable<int, int> IntHashT;
+	typedef HashTable<int, int, ConstantHash> ConstantHashT;
+
+	puts("testing stats");
+	{
+		IntHashT ht;
+		const int count = 10000;
+		for (int c = 0; c < count; c++) {
+			ht[c] = c;
+		}
+		for (int c = 0; c < count; c += 4) {
+			ht.erase(c);
+		}
+
+		const HashTableStats stats = ht.stats();
+		assert(stats.size == size_t(ht.size()));
+		assert(stats.bucketCount == ht.bucket_count());
+		assert(stats.loadFactor <= ht.max_load_factor());
+		assert(stats.resizeCount > 0);
+		assert(stats.hitProbes.total() == stats.size);
+		// chains still in the old table during incremental rehash are counted too
+		assert(stats.missProbes.total() >= stats.bucketCount);
+		assert(stats.hitProbes.percentile(0.5) >= 1);
+#ifdef HASH_TABLE_STATS_SAMPLING
+		assert(stats.sampledHits.total() > 0);
+#endif
+		// every remaining key is findable, so the erased ones left tombstones or nothing at all
+		assert(stats.tombstones == 0 || stats.tombstones == size_t(count / 4));
+	}
+
+	{
+		ConstantHashT ht;
+		const int count = 200;
+		for (int c = 0; c < count; c++) {
+			ht[c] = c;
+		}
+		const HashTableStats stats = ht.stats();
+		assert(stats.hitProbes.maxLength == count);
+		assert(stats.hitProbes.counts[LengthHistogram::size - 1] > 0);
+		assert(stats.hitProbes.mean() > 10);
+	}
+}
+
+/// Batched lookups must give the same results as find, including for a partial last group
+template <template <typename ...> class HashTable>
+void testFindBatch() {
+	typedef HashTable<int, int> IntHashT;
+
+	puts("testing find_batch");
+	IntHashT ht;
+	const int count = 10000;
+	for (int c = 0; c < count; c += 2) {
+		ht[c] = c * 3;
+	}
+
+	std::vector<int> keys;
+	for (int c = count + 7; c >= 0; c--) {
+		keys.push_back(c);
+	}
+	std::vector<typename IntHashT::iterator> out(keys.size());
+	const size_t found = ht.find_batch(keys.data(), keys.size(), out.data());
+	assert(found == size_t(ht.size()));
+	for (size_t c = 0; c < keys.size(); c++) {
+		assert(out[c] == ht.find(keys[c]));
+		if (out[c] != ht.end()) {
+			assert(out[c]->second == keys[c] * 3);
+		}
+	}
+
+	assert(ht.find_batch(keys.data(), 0, out.data()) == 0);
+}
+
+/// Fill a cuckoo table past 90% load, every key must stay in one of its two buckets or the stash
+template <template <typename ...> class HashTable>
+void testHighLoad() {
+	typedef HashTable<int, int> IntHashT;
+
+	puts("testing high load");
+	// 120000 elements in 2^17 slots is a load of 0.92
+	const int count = 120000;
+	IntHashT ht;
+	ht.max_load_factor(0.97f);
+	for (int c = 0; c < count; c++) {
+		// the returned iterator follows the new element through evictions, the stash and rebuilds
+		const typename IntHashT::iterator it = ht.insert(c * 7, c);
+		assert(it->first == c * 7 && it->second == c);
+	}
+	assert(ht.size() == count);
+	assert(float(ht.size()) / ht.bucket_count() > 0.9f);
+	for (int c = 0; c < count; c++) {
+		assert(ht.find(c * 7)->second == c);
+		assert(!ht.contains(c * 7 + 1));
+	}
+
+	int iterated = 0;
+	for (const auto &item : ht) {
+		assert(item.first == item.second * 7);
+		++iterated;
+	}
+	assert(iterated == count);
+
+	// inserting does not copy the key
+	HashTable<std::unique_ptr<int>, int> moveOnly;
+	for (int c = 0; c < 1000; c++) {
+		std::unique_ptr<int> key(new int(c));
+		const int *raw = key.get();
+		const auto result = moveOnly.try_emplace(std::move(key), c);
+		assert(result.second && result.first->first.get() == raw && result.first->second == c);
+	}
+	assert(moveOnly.size() == 1000);
+
+	// replace half of the keys without growing, freed slots are reused by the evictions
+	const size_t buckets = ht.bucket_count();
+	for (int c = 0; c < count; c += 2) {
+		ht.erase(c * 7);
+		ht.insert(c * 7 + 3, c);
+	}
+	assert(ht.size() == count);
+	assert(ht.bucket_count() == buckets);
+	for (int c = 0; c < count; c++) {
+		const int key = c % 2 ? c * 7 : c * 7 + 3;
+		assert(ht.find(key)->second == c);
+	}
+}
+
+/// Check a set of keys against std::unordered_set, including erase and re-insert over deleted buckets
+template <template <typename ...> class HashSetT>
+void testSet() {
+	typedef HashSetT<uint64_t> IntSetT;
+
+	puts("testing set");
+	const int count = 10000;
+	IntSetT set;
+	std::unordered_set<uint64_t> stdSet;
+	for (int c = 0; c < count; c++) {
+		const uint64_t key = uint64_t(rand()) % (count * 2);
+		const bool inserted = set.insert(key).second;
+		assert(inserted == stdSet.insert(key).second);
+		assert(*set.find(key) == key);
+	}
+	assert(set.size() == stdSet.size());
+
+	for (const uint64_t key : set) {
+		assert(stdSet.count(key));
+	}
+	for (uint64_t key = 0; key < count * 2; key++) {
+		assert(set.contains(key) == bool(stdSet.count(key)));
+	}
+
+	for (uint64_t key = 0; key < count * 2; key += 3) {
+		set.erase(key);
+		stdSet.erase(key);
+	}
+	assert(set.size() == stdSet.size());
+	for (uint64_t key = 0; key < count * 2; key++) {
+		assert(set.contains(key) == bool(stdSet.count(key)));
+	}
+
+	std::vector<uint64_t> keys = {1, 2, 3, 3, count * 3};
+	IntSetT fromRange(keys.begin(), keys.end());
+	assert(fromRange.size() == 4);
+	assert(fromRange.contains(count * 3));
+}
+
+/// Check that erase and clear release what the elements hold and leave a usable table
+template <template <typename ...> class HashTable>
+void testClear() {
+	typedef HashTable<int, std::shared_ptr<int>> SharedHashT;
+
+	puts("testing clear");
+	const int count = 1000;
+	std::shared_ptr<int> shared = std::make_shared<int>(1);
+	SharedHashT ht;
+	for (int c = 0; c < count; c++) {
+		ht.insert(c, shared);
+	}
+	for (int c = 0; c < count; c += 2) {
+		ht.erase(c);
+	}
+	assert(shared.use_count() == 1 + count / 2);
+	ht.clear();
+	assert(ht.size() == 0);
+	assert(shared.use_count() == 1);
+	assert(ht.find(1) == ht.end());
+
+	ht.insert(1, shared);
+	assert(ht.find(1)->second == shared);
+	assert(shared.use_count() == 2);
+}
+
+/// Check the FastHash family: transparent string hashing, seeding, spread of strided keys and the seed in snapshots
+void testFastHash() {
+	puts("testing fast hashers");
+	const FastHash<std::string> stringHash;
+	const std::string text = "the quick brown fox jumps over the lazy dog, then does it again and again";
+	for (size_t length = 0; length <= text.size(); length++) {
+		const std::string key = text.substr(0, length);
+		assert(stringHash(key) == stringHash(std::string_view(key)));
+		assert(stringHash(key) == FastStringHash()(key.c_str()));
+		// every prefix length goes through a different path of hashBytes up to the 48 byte lanes
+		if (length > 0) {
+			assert(stringHash(key) != stringHash(text.substr(0, length - 1)));
+		}
+		assert(stringHash(key) != FastHash<std::string>(1)(key));
+	}
+
+	// no collisions of the full hash for distinct keys
+	const int count = 100000;
+	std::unordered_set<size_t> hashes;
+	for (int c = 0; c < count; c++) {
+		hashes.insert(stringHash(std::to_string(c)));
+		hashes.insert(FastHash<int>()(c));
+	}
+	assert(hashes.size() == size_t(count) * 2);
+
+	// keys strided by the bucket count all land in one bucket with the identity hash
+	const size_t buckets = 1024;
+	std::vector<int> load(buckets);
+	for (size_t c = 0; c < buckets; c++) {
+		++load[FastHash<uint64_t>()(c * buckets) % buckets];
+	}
+	assert(*std::max_element(load.begin(), load.end()) < 12);
+
+	FastHashCOHashTable<int, int> co;
+	for (int c = 0; c < count; c++) {
+		co[c * int(buckets)] = c;
+	}
+	assert(co.stats().chainLength.maxLength < 12);
+
+	// the transparent string hasher needs no temporary key
+	OOHashTable<std::string, int, FastHash<std::string>> strings;
+	strings["key"] = 1;
+	assert(strings.find(std::string_view("key"))->second == 1);
+	assert(strings.contains("key"));
+
+	// the seed is recorded in snapshots, a view with another seed does not accept the file
+	typedef OOHashTable<uint64_t, int, FastHash<uint64_t>, LinearProber, PowerOfTwoCapacity> SeededHashT;
+	const uint64_t seed = randomHashSeed();
+	SeededHashT seeded{FastHash<uint64_t>(seed)};
+	for (int c = 0; c < 1000; c++) {
+		seeded[uint64_t(c)] = c;
+	}
+	const char *path = "hash-table-seeded-snapshot.bin";
+	const bool saved = seeded.save(path);
+	assert(saved);
+	typename SeededHashT::mapped sameSeed{FastHash<uint64_t>(seed)};
+	const bool opened = sameSeed.open(path);
+	assert(opened);
+	assert(sameSeed.find(500)->second == 500);
+	typename SeededHashT::mapped otherSeed{FastHash<uint64_t>(seed + 1)};
+	assert(!otherSeed.open(path));
+	remove(path);
+}
+
+/// Partitions must cover every element exactly once, also when empty, when there are more than buckets, and while migrating
+template <template <typename ...> class HashTable>
+void testPartitions() {
+	typedef HashTable<int, int> IntHashT;
+
+	puts("testing partitions and parallel_for_each");
+	IntHashT ht;
+	for (const size_t count : {size_t(1), size_t(3), size_t(100)}) {
+		int seen = 0;
+		for (auto &partition : ht.partitions(count)) {
+			seen += partition.begin() != partition.end();
+		}
+		assert(seen == 0);
+	}
+
+	const int size = 10000;
+	for (int c = 0; c < size; c++) {
+		ht[c] = c;
+	}
+
+	for (const size_t count : {size_t(1), size_t(7), size_t(64), size_t(1) << 20}) {
+		std::vector<int> seen(size);
+		for (auto &partition : ht.partitions(count)) {
+			for (auto &element : partition) {
+				++seen[element.first];
+			}
+		}
+		assert(std::count(seen.begin(), seen.end(), 1) == size);
+	}
+
+	std::atomic<int64_t> sum{0};
+	ht.parallel_for_each([&sum](std::pair<const int, int> &element) {
+		element.second *= 2;
+		sum += element.first;
+	}, 4);
+	assert(sum == int64_t(size) * (size - 1) / 2);
+	for (int c = 0; c < size; c++) {
+		assert(ht.find(c)->second == c * 2);
+	}
+}
+
+/// Tables allocate no buckets before the first insert and after clear, lookups on them find nothing
+template <template <typename ...> class HashTable>
+void testLazyAllocation() {
+	typedef HashTable<std::string, int> StringHashT;
+
+	puts("testing lazy allocation");
+	StringHashT ht;
+	assert(ht.bucket_count() == 0);
+	assert(ht.begin() == ht.end());
+	assert(ht.find("key") == ht.end());
+	assert(!ht.contains("key"));
+	assert(ht.erase("key") == ht.end());
+	assert(ht.stats().loadFactor == 0);
+	assert(ht.partitions(4).size() == 1);
+
+	ht["key"] = 1;
+	assert(ht.bucket_count() > 0);
+	assert(ht.find("key")->second == 1);
+
+	// copies of empty tables stay empty
+	StringHashT empty;
+	StringHashT copy(empty);
+	assert(copy.bucket_count() == 0);
+	copy["other"] = 2;
+	assert(copy.size() == 1);
+}
+
+/// Inline elements up to the limit, then the hashed table, with erase, copy and move on both sides of the switch
+template <template <typename ...> class HashTable>
+void testSmallTable() {
+	typedef HashTable<std::string, int> StringHashT;
+
+	puts("testing small table");
+	StringHashT ht;
+	for (int c = 0; c < 8; c++) {
+		ht[std::to_string(c)] = c;
+		assert(ht.isSmall());
+	}
+	assert(ht.size() == 8);
+
+	// erase moves the last inline element into the hole, erasing while iterating still visits every element
+	ht.erase("3");
+	assert(!ht.contains("3"));
+	assert(ht.find("7")->second == 7);
+	ht["3"] = 3;
+
+	StringHashT smallCopy(ht);
+	ht["8"] = 8;
+	assert(!ht.isSmall());
+	assert(smallCopy.isSmall());
+	for (int c = 0; c < 9; c++) {
+		assert(ht.find(std::to_string(c))->second == c);
+		assert(smallCopy.contains(std::to_string(c)) == (c < 8));
+	}
+
+	StringHashT moved(std::move(ht));
+	assert(ht.size() == 0 && ht.isSmall());
+	assert(moved.size() == 9);
+	ht = moved;
+	assert(ht.size() == 9);
+
+	int erased = 0;
+	for (typename StringHashT::iterator it = smallCopy.begin(); it != smallCopy.end(); ) {
+		it = smallCopy.erase(it);
+		++erased;
+	}
+	assert(erased == 8);
+	assert(smallCopy.size() == 0);
+
+	moved.clear();
+	assert(moved.isSmall());
+	assert(moved.size() == 0);
+	assert(moved.begin() == moved.end());
+}
+
+/// Huge page allocations are aligned to the huge page size, also when the system has no explicit huge pages reserved
+/// Iteration follows insertion order through erases, re-inserts and resizes, erased entries are dropped when it compacts
+template <template <typename ...> class HashTable>
+void testInsertionOrder() {
+	typedef HashTable<int, std::string> IntHashT;
+
+	puts("testing insertion order");
+	IntHashT ht;
+	assert(ht.bucket_count() == 0);
+	assert(ht.begin() == ht.end());
+	assert(!ht.contains(1));
+
+	// keys in an order unrelated to their hashes, enough of them to resize several times and cross the 1 and 2 byte index widths
+	const int size = 100000;
+	std::vector<int> order;
+	for (int c = 0; c < size; c++) {
+		order.push_back(int((c * 7919LL) % size));
+		ht[order.back()] = std::to_string(order.back());
+	}
+	assert(ht.size() == size);
+	{
+		std::vector<int>::iterator expected = order.begin();
+		for (auto &element : ht) {
+			assert(element.first == *expected);
+			assert(element.second == std::to_string(*expected));
+			++expected;
+		}
+		assert(expected == order.end());
+	}
+
+	// overwriting keeps the position, erasing and inserting again moves the key to the end
+	ht.insert_or_assign(order[0], "first");
+	assert(ht.begin()->second == "first");
+	ht.erase(order[0]);
+	assert(ht.begin()->first == order[1]);
+	ht[order[0]] = "last";
+	order.push_back(order[0]);
+	order.erase(order.begin());
+
+	// erase almost all keys, the inserts that fill the entries up to the load then compact them instead of growing
+	std::vector<int> kept;
+	for (const int key : order) {
+		if (key % 100) {
+			ht.erase(key);
+		} else {
+			kept.push_back(key);
+		}
+	}
+	const size_t buckets = ht.bucket_count();
+	for (int c = size; c < size * 19 / 10; c++) {
+		ht[c] = std::to_string(c);
+		kept.push_back(c);
+	}
+	assert(ht.bucket_count() == buckets);
+	assert(ht.size() == kept.size());
+	{
+		std::vector<int>::iterator expected = kept.begin();
+		for (auto &element : ht) {
+			assert(element.first == *expected);
+			++expected;
+		}
+		assert(expected == kept.end());
+	}
+	for (const int key : kept) {
+		assert(ht.find(key)->second == (key == order.back() ? "last" : std::to_string(key)));
+	}
+
+	// erasing while iterating visits the rest in order
+	int visited = 0;
+	for (typename IntHashT::iterator it = ht.begin(); it != ht.end(); visited++) {
+		assert(it->first == kept[visited]);
+		it = visited % 2 ? ht.erase(it) : ++it;
+	}
+	assert(visited == int(kept.size()));
+	assert(ht.size() == (kept.size() + 1) / 2);
+
+	ht.clear();
+	assert(ht.bucket_count() == 0);
+	assert(ht.begin() == ht.end());
+	ht[1] = "one";
+	assert(ht.find(1)->second == "one");
+}
+
+/// Snapshots keep the version they pinned, replaced versions are freed once no reader pins them,
+/// and readers running next to a writer always see whole versions
+template <template <typename ...> class HashTable>
+void testRcuTable() {
+	typedef HashTable<int, int> IntHashT;
+	typedef RcuHashTable<IntHashT> IntRcuT;
+	typedef HashTable<int, std::shared_ptr<int>> SharedHashT;
+	typedef RcuHashTable<SharedHashT> SharedRcuT;
+
+	puts("testing rcu table");
+	const int count = 1000;
+	{
+		IntRcuT ht;
+		assert(ht.size() == 0);
+		for (int c = 0; c < count; c++) {
+			const bool inserted = ht.insert(c, c);
+			assert(inserted);
+		}
+		const bool inserted = ht.insert(1, 2);
+		assert(!inserted);
+		int value = 0;
+		const bool found = ht.find(1, value);
+		assert(found && value == 2);
+		const bool erased = ht.erase(0);
+		const bool erasedAgain = ht.erase(0);
+		assert(erased && !erasedAgain);
+		assert(!ht.contains(0));
+		assert(ht.size() == count - 1);
+
+		ht.update([](IntHashT &table) {
+			for (int c = 0; c < count; c++) {
+				table[c] = -c;
+			}
+		});
+		assert(ht.size() == count);
+
+		{
+			auto snapshot = ht.snapshot();
+			ht.insert(count, count);
+			ht.erase(1);
+			// the pinned version does not change, a nested read section on the same thread sees the new one
+			assert(snapshot->find(count) == snapshot->end());
+			assert(snapshot->find(1)->second == -1);
+			assert(snapshot->size() == count);
+			assert(ht.contains(count) && !ht.contains(1));
+		}
+
+		IntHashT built;
+		built.insert(7, 7);
+		ht.assign(std::move(built));
+		assert(ht.size() == 1 && ht.contains(7));
+		ht.clear();
+		assert(ht.size() == 0);
+	}
+
+	{
+		// each version holds a copy of the pointer, so the use count tells how many versions are alive
+		std::shared_ptr<int> shared = std::make_shared<int>(1);
+		SharedRcuT ht;
+		ht.insert(0, shared);
+		assert(shared.use_count() == 2);
+		{
+			auto snapshot = ht.snapshot();
+			ht.insert(1, nullptr);
+			ht.insert(2, nullptr);
+			assert(shared.use_count() == 4);
+		}
+		ht.reclaim();
+		assert(shared.use_count() == 2);
+	}
+
+	{
+		// every version maps all keys to the same number, which only grows
+		IntRcuT ht;
+		ht.update([](IntHashT &table) {
+			for (int c = 0; c < count; c++) {
+				table[c] = 0;
+			}
+		});
+
+		std::atomic<bool> done{false};
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 3; t++) {
+			readers.emplace_back([&ht, &done]() {
+				int last = 0;
+				while (!done.load()) {
+					auto snapshot = ht.snapshot();
+					const int version = snapshot->find(0)->second;
+					assert(version >= last);
+					for (int c = 0; c < count; c += 37) {
+						assert(snapshot->find(c)->second == version);
+					}
+					last = version;
+				}
+			});
+		}
+		for (int version = 1; version <= 200; version++) {
+			ht.update([version](IntHashT &table) {
+				for (int c = 0; c < count; c++) {
+					table[c] = version;
+				}
+			});
+		}
+		done = true;
+		for (std::thread &reader : readers) {
+			reader.join();
+		}
+		int value = 0;
+		const bool found = ht.find(count - 1, value);
+		assert(found && value == 200);
+	}
+}
+
+/// Eviction order, overwrites, counters and byte charges with one shard so the order is exact, then threads on the sharded cache
+/// The accesses are chosen so LRU and CLOCK evict the same keys
+template <typename Eviction>
+void testLruCache() {
+	typedef LruCache<int, int, std::hash<int>, Eviction, UnitCharge, 1> IntCacheT;
+	typedef LruCache<int, std::string, std::hash<int>, Eviction, ByteCharge, 1> StringCacheT;
+
+	puts("testing lru cache");
+	{
+		IntCacheT cache(4);
+		for (int c = 0; c < 4; c++) {
+			const bool inserted = cache.put(c, c);
+			assert(inserted);
+		}
+		assert(cache.size() == 4);
+
+		// the hit saves 0 from the next eviction, 1 is the oldest entry not used since
+		int value = -1;
+		bool found = cache.get(0, value);
+		assert(found && value == 0);
+		cache.put(4, 4);
+		assert(cache.size() == 4);
+		assert(cache.contains(0) && !cache.contains(1));
+
+		// overwriting does not grow the cache, 2 is still the oldest and goes next
+		const bool inserted = cache.put(3, 30);
+		assert(!inserted);
+		found = cache.get(3, value);
+		assert(found && value == 30);
+		cache.put(5, 5);
+		assert(!cache.contains(2) && cache.contains(3) && cache.contains(0));
+
+		found = cache.get(1, value);
+		assert(!found);
+		const CacheStats stats = cache.stats();
+		assert(stats.hits == 2 && stats.misses == 1 && stats.evictions == 2);
+		assert(stats.size == 4 && stats.charge == 4);
+
+		const bool erased = cache.erase(4);
+		const bool erasedAgain = cache.erase(4);
+		assert(erased && !erasedAgain);
+		assert(cache.size() == 3);
+		cache.clear();
+		assert(cache.size() == 0 && !cache.contains(0));
+		cache.put(1, 1);
+		assert(cache.contains(1));
+	}
+
+	{
+		StringCacheT cache(4096);
+		for (int c = 0; c < 10; c++) {
+			cache.put(c, std::string(1000, 'x'));
+		}
+		const CacheStats stats = cache.stats();
+		assert(stats.charge <= 4096);
+		assert(stats.size >= 2 && stats.size < 4);
+		assert(cache.contains(9));
+
+		// larger than the whole capacity, evicts everything else and stays
+		cache.put(100, std::string(10000, 'y'));
+		assert(cache.size() == 1 && cache.contains(100));
+		cache.put(101, "z");
+		assert(cache.size() == 1 && cache.contains(101));
+	}
+
+	{
+		LruCache<int, int, std::hash<int>, Eviction> cache(1000);
+		const int threads = 4, ops = 20000, keys = 2000;
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([&cache, t]() {
+				std::mt19937 rng(t);
+				for (int c = 0; c < ops; c++) {
+					const int key = int(rng() % keys);
+					int value = -1;
+					if (cache.get(key, value)) {
+						assert(value == key);
+					} else {
+						cache.put(key, key);
+					}
+				}
+			});
+		}
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+		const CacheStats stats = cache.stats();
+		assert(stats.hits + stats.misses == uint64_t(threads) * ops);
+		assert(stats.hits > 0 && stats.evictions > 0);
+		assert(cache.size() <= cache.capacity());
+	}
+}
+
+void testHugePages() {
+	puts("testing huge page allocation");
+	for (const size_t bytes : {size_t(1), size_t(hugePageSize) - 1, size_t(hugePageSize), size_t(hugePageSize) * 3 + 5}) {
+		char *data = static_cast<char *>(allocateHugePages(bytes));
+		assert(data);
+		assert(reinterpret_cast<uintptr_t>(data) % hugePageSize == 0);
+		// the whole rounded up range is writable
+		std::fill(data, data + bytes, char(1));
+		freeHugePages(data, bytes);
+	}
+
+	HugePageAllocator<uint64_t, 1 << 20> allocator;
+	std::vector<uint64_t, HugePageAllocator<uint64_t, 1 << 20>> small(10, 0, allocator), large(1 << 20, 0, allocator);
+	large.back() = small.size();
+	assert(large.back() == 10);
+	assert(reinterpret_cast<uintptr_t>(large.data()) % hugePageSize == 0);
+}
+
+/// Save an open addressing table and read it back through a mapped view
+template <template <typename ...> class HashTable>
+void testSnapshot() {
+	struct Point {
+		int x, y;
+		double weight;
+	};
+	typedef HashTable<uint64_t, Point> PointHashT;
+
+	puts("testing snapshot save and mapped view");
+	const char *path = "hash-table-snapshot.bin";
+	const int count = 10000;
+	PointHashT ht;
+	for (int c = 0; c < count; c++) {
+		ht[uint64_t(c) * 7919] = Point{c, -c, c * 0.5};
+	}
+	// deleted buckets must still continue the probe sequences in the view
+	for (int c = 0; c < count; c += 3) {
+		ht.erase(uint64_t(c) * 7919);
+	}
+	// not inside assert, the tests must still save and open with NDEBUG
+	const bool saved = ht.save(path);
+	assert(saved);
+
+	typename PointHashT::mapped view;
+	const bool opened = view.open(path);
+	assert(opened);
+	assert(view.size() == ht.size());
+	assert(view.bucket_count() == ht.bucket_count());
+	for (int c = 0; c < count; c++) {
+		const uint64_t key = uint64_t(c) * 7919;
+		if (c % 3 == 0) {
+			assert(!view.contains(key));
+			assert(view.find(key) == view.end());
+		} else {
+			assert(view.find(key) != view.end());
+			assert(view.find(key)->second.x == c && view.find(key)->second.y == -c);
+		}
+		assert(!view.contains(key + 1));
+	}
+
+	size_t seen = 0;
+	for (typename PointHashT::mapped::iterator it = view.begin(); it != view.end(); ++it) {
+		assert(ht.find(it->first)->second.weight == it->second.weight);
+		++seen;
+	}
+	assert(seen == ht.size());
+
+	// a table with another layout must not accept the file
+	typename HashTable<uint64_t, int>::mapped wrongType;
+	assert(!wrongType.open(path));
+	assert(!view.open("missing-hash-table-snapshot.bin"));
+	assert(!view.isOpen());
+
+	// a table without any insert has no buckets yet, its snapshot is only the header
+	PointHashT empty;
+	const bool savedEmpty = empty.save(path);
+	assert(savedEmpty);
+	const bool openedEmpty = view.open(path);
+	assert(openedEmpty);
+	assert(view.size() == 0 && view.bucket_count() == 0);
+	assert(view.begin() == view.end());
+	assert(!view.contains(1));
+	assert(view.find(1) == view.end());
+
+	remove(path);
+}
+
+/// Several threads insert disjoint key ranges and update shared counters at the same time
+void testConcurrentTable() {
+	ConcurrentHashTable<int, int> ht;
+	const int threadCount = 8;
+	const int perThread = 10000;
+	const int counters = 100;
+
+	puts("testing concurrent inserts and upserts");
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&ht, t]() {
+			for (int c = 0; c < perThread; c++) {
+				ht.insert(counters + t * perThread + c, t);
+				ht.upsert(c % counters, [](int &value) { ++value; });
+			}
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+
+	assert(ht.size() == counters + threadCount * perThread);
+	for (int c = 0; c < counters; c++) {
+		int value = 0;
+		assert(ht.find(c, value));
+		assert(value == threadCount * perThread / counters);
+	}
+	for (int c = 0; c < threadCount * perThread; c++) {
+		int value = -1;
+		assert(ht.find(counters + c, value));
+		assert(value == c / perThread);
+	}
+
+	puts("testing concurrent erases");
+	threads.clear();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&ht, t]() {
+			for (int c = 0; c < perThread; c++) {
+				ht.erase(counters + t * perThread + c);
+			}
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+
+	assert(ht.size() == counters);
+	assert(!ht.contains(counters));
+}
+
+/// Threads increment shared counters and insert disjoint keys while the table resizes many times
+void testLockFreeTable() {
+	// start small so the cooperative resize runs while threads are writing
+	LockFreeHashTable<uint64_t, uint64_t> ht(16);
+	const int threadCount = 8;
+	const int perThread = 20000;
+	const int counters = 50;
+
+	puts("testing concurrent adds and inserts with resize");
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&ht, t]() {
+			for (int c = 0; c < perThread; c++) {
+				ht.add(c % counters, 1);
+				ht.insert(counters + t * perThread + c, t);
+				uint64_t value;
+				if (ht.find(counters + t * perThread + c / 2, value)) {
+					assert(value == uint64_t(t));
+				}
+			}
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+
+	assert(ht.size() == counters + threadCount * perThread);
+	for (int c = 0; c < counters; c++) {
+		uint64_t value = 0;
+		assert(ht.find(c, value));
+		assert(value == threadCount * perThread / counters);
+	}
+	for (int c = 0; c < threadCount * perThread; c++) {
+		uint64_t value = 0;
+		assert(ht.find(counters + c, value));
+		assert(value == uint64_t(c / perThread));
+	}
+
+	puts("testing concurrent erases");
+	threads.clear();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&ht, t]() {
+			for (int c = 0; c < perThread; c++) {
+				ht.erase(counters + t * perThread + c);
+			}
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+
+	assert(ht.size() == counters);
+	uint64_t value;
+	assert(!ht.find(counters, value));
+	assert(ht.add(0, 5) == threadCount * perThread / counters + 5);
+
+	puts("testing insert and erase churn in bounded memory");
+	// every key is new, so the tombstones fill the table and force a resize every few inserts
+	LockFreeHashTable<uint64_t, uint64_t> churn(16);
+	threads.clear();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&churn, t]() {
+			for (int c = 0; c < perThread * 5; c++) {
+				const uint64_t key = uint64_t(t) * perThread * 5 + c;
+				churn.insert(key, c);
+				uint64_t found;
+				assert(churn.find(key, found) && found == uint64_t(c));
+				assert(churn.erase(key));
+				assert(!churn.find(key, found));
+			}
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+	churn.reclaim();
+	assert(churn.size() == 0);
+	// at most eight keys are live, and only the current table, a resize target twice as big and the spare are left
+	assert(churn.bucket_count() <= 64);
+	assert(churn.allocated_slots() <= 5 * churn.bucket_count());
+
+	// lookups never grow the table
+	const size_t allocated = churn.allocated_slots();
+	for (int c = 0; c < perThread; c++) {
+		assert(!churn.find(c, value));
+	}
+	assert(churn.allocated_slots() == allocated);
 }
 
 int main()
@@ -153,6 +1325,173 @@ int main()
 	testTable<OOHashTable>();
 	puts("- done");
 
+	puts("- power of two closed addressing hash table");
+	testTable<PowerOfTwoCOHashTable>();
+	puts("- done");
+
+	puts("- power of two open addressing hash table");
+	testTable<PowerOfTwoOOHashTable>();
+	puts("- done");
+
+	puts("- incremental rehash closed addressing hash table");
+	testTable<IncrementalCOHashTable>();
+	testEmplace<IncrementalCOHashTable>();
+	puts("- done");
+
+	puts("- quadratic probing hash table");
+	testTable<QuadraticOOHashTable>();
+	testReserve<QuadraticOOHashTable>();
+	testStats<QuadraticOOHashTable>();
+	puts("- done");
+
+	puts("- double hashing hash table");
+	testTable<DoubleHashOOHashTable>();
+	testTable<PrimeDoubleHashOOHashTable>();
+	testReserve<PrimeDoubleHashOOHashTable>();
+	testFindBatch<DoubleHashOOHashTable>();
+	testSnapshot<PrimeDoubleHashOOHashTable>();
+	puts("- done");
+
+	puts("- prime capacity closed addressing hash table");
+	testTable<PrimeCOHashTable>();
+	puts("- done");
+
+	puts("- stored hash closed addressing hash table");
+	testTable<StoredHashCOHashTable>();
+	testEmplace<StoredHashCOHashTable>();
+	testReserve<StoredHashCOHashTable>();
+	testTransparent<StoredHashCOHashTable>();
+	puts("- done");
+
+	puts("- stored hash open addressing hash table");
+	testTable<StoredHashOOHashTable>();
+	testEmplace<StoredHashOOHashTable>();
+	testReserve<StoredHashOOHashTable>();
+	testTransparent<StoredHashOOHashTable>();
+	testFindBatch<StoredHashOOHashTable>();
+	testSnapshot<StoredHashOOHashTable>();
+	puts("- done");
+
+	puts("- node pool closed addressing hash table");
+	testTable<PoolHashTable>();
+	puts("- done");
+
+	puts("- emplace");
+	testEmplace<COHashTable>();
+	testEmplace<OOHashTable>();
+	testEmplace<PowerOfTwoOOHashTable>();
+	puts("- done");
+
+	puts("- reserve and bulk construction");
+	testReserve<COHashTable>();
+	testReserve<OOHashTable>();
+	testReserve<PowerOfTwoCOHashTable>();
+	testReserve<PowerOfTwoOOHashTable>();
+	testReserve<IncrementalCOHashTable>();
+	puts("- done");
+
+	puts("- stats");
+	testStats<COHashTable>();
+	testStats<OOHashTable>();
+	testStats<StoredHashOOHashTable>();
+	testStats<IncrementalCOHashTable>();
+	puts("- done");
+
+	puts("- batched lookup");
+	testFindBatch<OOHashTable>();
+	testFindBatch<PowerOfTwoOOHashTable>();
+	puts("- done");
+
+	puts("- snapshot");
+	testSnapshot<OOHashTable>();
+	testSnapshot<PowerOfTwoOOHashTable>();
+	puts("- done");
+
+	puts("- heterogeneous lookup");
+	testTransparent<COHashTable>();
+	testTransparent<OOHashTable>();
+	puts("- done");
+
+	puts("- swiss hash table");
+	testTable<SwissHashTable>();
+	puts("- done");
+
+	puts("- robin hood hash table");
+	testTable<RobinHoodHashTable>();
+	puts("- done");
+
+	puts("- cuckoo hash table");
+	testTable<CuckooHashTable>();
+	testEmplace<CuckooHashTable>();
+	testReserve<CuckooHashTable>();
+	testHighLoad<CuckooHashTable>();
+	puts("- done");
+
+	puts("- flat hash table and set");
+	testTable<FlatHashTable>();
+	testEmplace<FlatHashTable>();
+	testReserve<FlatHashTable>();
+	testClear<FlatHashTable>();
+	testSet<HashSet>();
+	puts("- done");
+
+	puts("- fast hashers");
+	testTable<FastHashCOHashTable>();
+	testTable<FastHashOOHashTable>();
+	testFastHash();
+	puts("- done");
+
+	puts("- partitioned iteration");
+	testPartitions<COHashTable>();
+	testPartitions<OOHashTable>();
+	testPartitions<IncrementalCOHashTable>();
+	puts("- done");
+
+	puts("- lazy allocation and small tables");
+	testLazyAllocation<COHashTable>();
+	testLazyAllocation<OOHashTable>();
+	testLazyAllocation<IncrementalCOHashTable>();
+	testTable<SmallCOHashTable>();
+	testTable<SmallOOHashTable>();
+	testEmplace<SmallCOHashTable>();
+	testEmplace<SmallOOHashTable>();
+	testSmallTable<SmallCOHashTable>();
+	testSmallTable<SmallOOHashTable>();
+	puts("- done");
+
+	puts("- huge page buckets");
+	testHugePages();
+	testTable<HugePageOOHashTable>();
+	testEmplace<HugePageOOHashTable>();
+	testReserve<HugePageOOHashTable>();
+	puts("- done");
+
+	puts("- compact insertion ordered table");
+	testTable<CompactHashTable>();
+	testEmplace<CompactHashTable>();
+	testReserve<CompactHashTable>();
+	testPartitions<CompactHashTable>();
+	testInsertionOrder<CompactHashTable>();
+	puts("- done");
+
+	puts("- rcu hash table");
+	testRcuTable<COHashTable>();
+	testRcuTable<OOHashTable>();
+	puts("- done");
+
+	puts("- lru cache");
+	testLruCache<LruEviction>();
+	testLruCache<ClockEviction>();
+	puts("- done");
+
+	puts("- concurrent hash table");
+	testConcurrentTable();
+	puts("- done");
+
+	puts("- lock-free hash table");
+	testLockFreeTable();
+	puts("- done");
+
 	puts("press enter to exit");
 	getchar();
 }
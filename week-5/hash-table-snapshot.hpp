@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// Header of a table snapshot file, followed right after by the raw bucket array
+/// The file is only readable on a machine with the same endianness and the same table instantiation:
+/// key, value, hash, probe and capacity policy types must match the ones used to save it
+struct SnapshotHeader {
+	enum : uint32_t {
+		currentVersion = 2, ///< Bump when the bucket layout or the header changes, 2 added flags
+		endianMark = 0x01020304, ///< Written in native byte order
+	};
+
+	char magic[8]; ///< "HTSNAP" followed by zeroes
+	uint32_t version; ///< Layout version, currentVersion when written
+	uint32_t headerSize; ///< sizeof(SnapshotHeader), offset of the first bucket
+	uint64_t capacity; ///< Number of buckets
+	uint64_t count; ///< Number of elements
+	uint64_t seed; ///< Seed of the hasher, see hashSeed
+	uint32_t bucketSize; ///< sizeof of one bucket
+	uint32_t keySize; ///< sizeof of the key
+	uint32_t valueSize; ///< sizeof of the value
+	uint32_t endian; ///< endianMark
+	uint32_t flags; ///< Layout options of the bucket, like HashStore::snapshotFlag
+	uint32_t reserved; ///< Zero, pads the header to 64 bytes
+
+	/// Header for a table with given sizes
+	static SnapshotHeader make(uint64_t capacity, uint64_t count, uint64_t seed, uint32_t flags, size_t bucketSize, size_t keySize, size_t valueSize) {
+		SnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "HTSNAP", 6);
+		header.version = currentVersion;
+		header.headerSize = sizeof(SnapshotHeader);
+		header.capacity = capacity;
+		header.count = count;
+		header.seed = seed;
+		header.bucketSize = uint32_t(bucketSize);
+		header.keySize = uint32_t(keySize);
+		header.valueSize = uint32_t(valueSize);
+		header.endian = endianMark;
+		header.flags = flags;
+		return header;
+	}
+
+	/// Check if this header was written by the same layout version for the given flags and sizes and matches the file size
+	bool matches(uint64_t seed, uint32_t flags, size_t bucketSize, size_t keySize, size_t valueSize, size_t fileSize) const {
+		return !memcmp(magic, "HTSNAP\0\0", 8)
+			&& version == currentVersion
+			&& headerSize == sizeof(SnapshotHeader)
+			&& endian == endianMark
+			&& this->seed == seed
+			&& this->flags == flags
+			&& this->bucketSize == bucketSize
+			&& this->keySize == keySize
+			&& this->valueSize == valueSize
+			// a table saved before its first insert has no buckets
+			&& (capacity ? count < capacity : count == 0)
+			&& fileSize >= headerSize
+			&& (fileSize - headerSize) / bucketSize == capacity
+			&& (fileSize - headerSize) % bucketSize == 0;
+	}
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "Snapshot header must keep its size, buckets start right after it");
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// Histogram of probe or chain lengths, lengths at or above size - 1 are counted in the last bucket
+struct LengthHistogram {
+	enum : int { size = 32 };
+
+	uint64_t counts[size] = {}; ///< counts[c] is the number of samples with length c
+	size_t maxLength = 0; ///< Longest length added, even if it went into the last bucket
+
+	void add(size_t length, uint64_t times = 1) {
+		if (!times) {
+			return;
+		}
+		counts[length < size ? length : size - 1] += times;
+		maxLength = length > maxLength ? length : maxLength;
+	}
+
+	uint64_t total() const {
+		uint64_t result = 0;
+		for (uint64_t count : counts) {
+			result += count;
+		}
+		return result;
+	}
+
+	/// Average length, lengths in the last bucket are counted as size - 1
+	double mean() const {
+		uint64_t sum = 0;
+		for (int c = 0; c < size; c++) {
+			sum += counts[c] * c;
+		}
+		const uint64_t samples = total();
+		return samples ? double(sum) / samples : 0;
+	}
+
+	/// Smallest length that at least fraction of the samples do not exceed
+	size_t percentile(double fraction) const {
+		const uint64_t samples = total();
+		uint64_t seen = 0;
+		for (int c = 0; c < size; c++) {
+			seen += counts[c];
+			if (seen > 0 && seen >= fraction * samples) {
+				return c;
+			}
+		}
+		return 0;
+	}
+};
+
+/// Snapshot of the shape of a table returned by stats()
+/// A probe is one key comparison in a chain for closed addressing and one bucket visited for open addressing
+struct HashTableStats {
+	size_t size = 0; ///< Number of elements
+	size_t bucketCount = 0; ///< Number of buckets
+	double loadFactor = 0; ///< size / bucketCount
+	size_t tombstones = 0; ///< Deleted buckets still on probe sequences, always 0 for closed addressing
+	size_t resizeCount = 0; ///< Number of resizes and rehashes since construction
+	double resizeSeconds = 0; ///< Total time spent in them
+
+	LengthHistogram chainLength; ///< Elements per bucket for closed addressing, length of runs of used buckets for open addressing
+	LengthHistogram hitProbes; ///< Probes a successful lookup of each element takes
+	LengthHistogram missProbes; ///< Probes a failed lookup takes when starting from each bucket
+
+	/// Probes of actual lookups, every sampleRate-th one, only filled when HASH_TABLE_STATS_SAMPLING is defined
+	LengthHistogram sampledHits;
+	LengthHistogram sampledMisses;
+};
+
+/// Counts resizes and the time spent in them
+class ResizeCounter {
+	size_t count = 0;
+	std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+public:
+	/// Measures one resize for as long as it lives
+	class Scope {
+		ResizeCounter &owner;
+		std::chrono::steady_clock::time_point start;
+	public:
+		explicit Scope(ResizeCounter &owner)
+			: owner(owner)
+			, start(std::chrono::steady_clock::now()) {}
+
+		~Scope() {
+			++owner.count;
+			owner.time += std::chrono::steady_clock::now() - start;
+		}
+	};
+
+	void fill(HashTableStats &stats) const {
+		stats.resizeCount = count;
+		stats.resizeSeconds = std::chrono::duration<double>(time).count();
+	}
+};
+
+#ifdef HASH_TABLE_STATS_SAMPLING
+
+/// Records the probe count of every sampleRate-th lookup
+/// Counters are relaxed atomics since lookups may run concurrently under a shared lock, see ConcurrentHashTable
+class LookupSampler {
+	enum : uint32_t { sampleRate = 64 };
+
+	std::atomic<uint32_t> tick{0};
+	std::atomic<uint64_t> hits[LengthHistogram::size] = {};
+	std::atomic<uint64_t> misses[LengthHistogram::size] = {};
+public:
+	LookupSampler() = default;
+
+	/// Copies start with no samples
+	LookupSampler(const LookupSampler &) {}
+
+	LookupSampler & operator=(const LookupSampler &) {
+		return *this;
+	}
+
+	void record(bool found, size_t probes) {
+		if (tick.fetch_add(1, std::memory_order_relaxed) % sampleRate) {
+			return;
+		}
+		const size_t idx = probes < LengthHistogram::size ? probes : LengthHistogram::size - 1;
+		(found ? hits : misses)[idx].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void fill(HashTableStats &stats) const {
+		for (size_t c = 0; c < LengthHistogram::size; c++) {
+			stats.sampledHits.add(c, hits[c].load(std::memory_order_relaxed));
+			stats.sampledMisses.add(c, misses[c].load(std::memory_order_relaxed));
+		}
+	}
+};
+
+#else
+
+/// Sampling compiled out, the calls on the lookup paths are empty and the probe counting is optimized away
+class LookupSampler {
+public:
+	void record(bool, size_t) {}
+	void fill(HashTableStats &) const {}
+};
+
+#endif
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/// Check if a hasher opts in to heterogeneous lookup by declaring is_transparent
+/// Tables with a transparent hasher accept any key type the hasher can hash and that is comparable with == to the key
+template <typename Hash, typename = void>
+struct IsTransparent : std::false_type {};
+
+template <typename Hash>
+struct IsTransparent<Hash, std::void_t<typename Hash::is_transparent>> : std::true_type {};
+
+
+/// Transparent hash for std::string keys
+/// std::string, std::string_view and C strings hash the same, so lookups with views do not allocate
+struct StringHash {
+	typedef void is_transparent;
+
+	size_t operator()(std::string_view str) const {
+		return std::hash<std::string_view>()(str);
+	}
+};
+
+
+/// Seed of a hasher that has a seed() method, 0 for hashers without one (like std::hash)
+/// Stored in table snapshots so a snapshot is not read with a hasher seeded differently
+template <typename Hash, typename = void>
+struct HashSeed {
+	static uint64_t get(const Hash &) {
+		return 0;
+	}
+};
+
+template <typename Hash>
+struct HashSeed<Hash, std::void_t<decltype(std::declval<const Hash &>().seed())>> {
+	static uint64_t get(const Hash &hasher) {
+		return uint64_t(hasher.seed());
+	}
+};
+
+template <typename Hash>
+uint64_t hashSeed(const Hash &hasher) {
+	return HashSeed<Hash>::get(hasher);
+}
+
+
+/// Full 128 bit product of a and b, low half in a and high half in b
+inline void multiply128(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+	const __uint128_t product = __uint128_t(a) * b;
+	a = uint64_t(product);
+	b = uint64_t(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	a = _umul128(a, b, &b);
+#else
+	const uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32, bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+	const uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+	const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+	a = (middle << 32) | (lowLow & 0xFFFFFFFF);
+	b = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+#endif
+}
+
+/// Multiply and fold the high half of the product onto the low half, every input bit affects every output bit
+inline uint64_t multiplyFold(uint64_t a, uint64_t b) {
+	multiply128(a, b);
+	return a ^ b;
+}
+
+/// Odd constants with balanced bits from wyhash
+enum : uint64_t {
+	hashSecret0 = 0xa0761d6478bd642full,
+	hashSecret1 = 0xe7037ed1a0b428dbull,
+	hashSecret2 = 0x8ebc6af09c88c6e3ull,
+	hashSecret3 = 0x589965cc75374cc3ull,
+};
+
+/// Unaligned little endian reads, memcpy compiles to a single load
+inline uint64_t readBytes64(const uint8_t *bytes) {
+	uint64_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+inline uint64_t readBytes32(const uint8_t *bytes) {
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+/// Hash of a 64 bit value, one multiply
+inline uint64_t hashInteger(uint64_t value, uint64_t seed) {
+	return multiplyFold(value ^ seed ^ hashSecret0, hashSecret1);
+}
+
+/// Hash of length bytes following wyhash: 16 bytes per multiply, three independent lanes for inputs over 48 bytes,
+/// and short inputs read with overlapping loads instead of a loop
+inline uint64_t hashBytes(const void *data, size_t length, uint64_t seed) {
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	seed ^= multiplyFold(seed ^ hashSecret0, hashSecret1);
+	uint64_t a, b;
+	if (length <= 16) {
+		if (length >= 4) {
+			// two pairs of 4 byte reads covering all the bytes, they overlap for lengths below 16
+			const size_t offset = (length >> 3) << 2;
+			a = (readBytes32(bytes) << 32) | readBytes32(bytes + offset);
+			b = (readBytes32(bytes + length - 4) << 32) | readBytes32(bytes + length - 4 - offset);
+		} else if (length > 0) {
+			a = (uint64_t(bytes[0]) << 16) | (uint64_t(bytes[length >> 1]) << 8) | bytes[length - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t remaining = length;
+		if (remaining > 48) {
+			uint64_t lane1 = seed, lane2 = seed;
+			do {
+				seed = multiplyFold(readBytes64(bytes) ^ hashSecret1, readBytes64(bytes + 8) ^ seed);
+				lane1 = multiplyFold(readBytes64(bytes + 16) ^ hashSecret2, readBytes64(bytes + 24) ^ lane1);
+				lane2 = multiplyFold(readBytes64(bytes + 32) ^ hashSecret3, readBytes64(bytes + 40) ^ lane2);
+				bytes += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= lane1 ^ lane2;
+		}
+		while (remaining > 16) {
+			seed = multiplyFold(readBytes64(bytes) ^ hashSecret1, readBytes64(bytes + 8) ^ seed);
+			bytes += 16;
+			remaining -= 16;
+		}
+		// the last 16 bytes, overlapping the ones already mixed when remaining is below 16
+		a = readBytes64(bytes + remaining - 16);
+		b = readBytes64(bytes + remaining - 8);
+	}
+	a ^= hashSecret1;
+	b ^= seed;
+	multiply128(a, b);
+	return multiplyFold(a ^ hashSecret0 ^ length, b ^ hashSecret1);
+}
+
+/// Seed from std::random_device and the clock, for tables whose hashes must not be predictable from the keys
+inline uint64_t randomHashSeed() {
+	std::random_device device;
+	const uint64_t bits = (uint64_t(device()) << 32) | device();
+	return bits ^ uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+/// Seed shared by the FastHash hashers, seed() is picked up by hashSeed so snapshots record it
+class FastHashSeed {
+protected:
+	uint64_t seedValue; ///< Mixed into every hash
+public:
+	/// The default seed 0 gives the same hashes in every process, pass randomHashSeed() for per table seeding
+	explicit FastHashSeed(uint64_t seed = 0)
+		: seedValue(seed) {}
+
+	uint64_t seed() const {
+		return seedValue;
+	}
+};
+
+/// Fast non-cryptographic hasher family, usable as the Hash argument of every table
+/// Unlike std::hash it never returns the key itself for integers, so modulo sizing and linear probing
+/// get well spread indices for sequential or strided keys.
+/// Types without a specialization have their std::hash mixed with the seed.
+template <typename K, typename = void>
+struct FastHash : FastHashSeed {
+	using FastHashSeed::FastHashSeed;
+
+	size_t operator()(const K &key) const {
+		return size_t(hashInteger(uint64_t(std::hash<K>()(key)), seedValue));
+	}
+};
+
+/// Integers, enums and pointers are mixed with a single multiply
+template <typename K>
+struct FastHash<K, std::enable_if_t<std::is_integral<K>::value || std::is_enum<K>::value || std::is_pointer<K>::value>> : FastHashSeed {
+	using FastHashSeed::FastHashSeed;
+
+	size_t operator()(K key) const {
+		if constexpr (std::is_pointer<K>::value) {
+			return size_t(hashInteger(uint64_t(reinterpret_cast<uintptr_t>(key)), seedValue));
+		} else {
+			return size_t(hashInteger(uint64_t(key), seedValue));
+		}
+	}
+};
+
+/// Transparent byte string hash, std::string, std::string_view and C strings hash the same like with StringHash
+struct FastStringHash : FastHashSeed {
+	typedef void is_transparent;
+
+	using FastHashSeed::FastHashSeed;
+
+	size_t operator()(std::string_view str) const {
+		return size_t(hashBytes(str.data(), str.size(), seedValue));
+	}
+};
+
+template <>
+struct FastHash<std::string> : FastStringHash {
+	using FastStringHash::FastStringHash;
+};
+
+template <>
+struct FastHash<std::string_view> : FastStringHash {
+	using FastStringHash::FastStringHash;
+};
+
+
+/// Hash storage policies for COHashTable and OOHashTable
+/// Each provides a Slot type that the table's element or bucket derives from, so a policy storing nothing costs no memory:
+///  - setHash(hash) - remember the hash of the key put in the slot
+///  - mayMatch(hash) - false if a key with this hash can not be the one in the slot, checked before comparing keys
+///  - hashOf(key, hasher) - hash of the key in the slot, used when rehashing
+///  - snapshotFlag - recorded in snapshots since it changes the bucket layout
+
+/// Store nothing, every probed key is compared and hashes are recomputed on rehash
+struct NoStoredHash {
+	enum : uint32_t { snapshotFlag = 0 };
+
+	struct Slot {
+		void setHash(size_t) {}
+
+		bool mayMatch(size_t) const {
+			return true;
+		}
+
+		template <typename Key, typename Hash>
+		size_t hashOf(const Key &key, const Hash &hasher) const {
+			return hasher(key);
+		}
+	};
+};
+
+/// Store the full hash next to each element, rehash never calls the hasher and keys are compared only on equal hashes
+/// Worth it for keys that are slow to hash or compare, like long strings; the full hash is kept since
+/// the capacity policies need all of it to compute an index
+struct StoredHash {
+	enum : uint32_t { snapshotFlag = 1 };
+
+	struct Slot {
+		size_t hash = 0; ///< Hash of the key in the slot
+
+		void setHash(size_t value) {
+			hash = value;
+		}
+
+		bool mayMatch(size_t value) const {
+			return hash == value;
+		}
+
+		template <typename Key, typename Hash>
+		size_t hashOf(const Key &, const Hash &) const {
+			return hash;
+		}
+	};
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/// Huge page size the allocations are aligned and rounded to, 2 MiB on x86-64 and most ARM64 kernels
+enum : size_t { hugePageSize = size_t(2) << 20 };
+
+/// Allocate bytes backed by huge pages if the system gives them, else by normal pages aligned so they can be promoted later
+/// Tries explicit huge pages first (MAP_HUGETLB, needs pages reserved in /proc/sys/vm/nr_hugepages), then a normal
+/// mapping with madvise(MADV_HUGEPAGE) for transparent huge pages. Returns nullptr on failure.
+/// Must be freed with freeHugePages and the same bytes.
+inline void * allocateHugePages(size_t bytes) {
+	const size_t length = (bytes + hugePageSize - 1) & ~(hugePageSize - 1);
+#ifdef _WIN32
+	// large pages need SeLockMemoryPrivilege, without it the normal allocation is used
+	void *result = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+	if (!result) {
+		result = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+	return result;
+#else
+#ifdef MAP_HUGETLB
+	void *result = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (result != MAP_FAILED) {
+		return result;
+	}
+#endif
+	// map one huge page more and trim both ends, so the kernel can back the whole range with aligned huge pages
+	char *mapping = static_cast<char *>(mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (mapping == MAP_FAILED) {
+		return nullptr;
+	}
+	char *aligned = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(mapping) + hugePageSize - 1) & ~uintptr_t(hugePageSize - 1));
+	if (aligned != mapping) {
+		munmap(mapping, aligned - mapping);
+	}
+	munmap(aligned + length, mapping + hugePageSize - aligned);
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+	return aligned;
+#endif
+}
+
+inline void freeHugePages(void *data, size_t bytes) {
+#ifdef _WIN32
+	(void)bytes;
+	VirtualFree(data, 0, MEM_RELEASE);
+#else
+	munmap(data, (bytes + hugePageSize - 1) & ~(hugePageSize - 1));
+#endif
+}
+
+/// Allocator giving huge page backed memory to allocations of at least Threshold bytes and using operator new for smaller ones
+/// For big open addressing tables, where random probes miss the TLB on almost every lookup with 4 KiB pages.
+/// Stateless, all instances are equal.
+template <typename T, size_t Threshold = size_t(64) << 20>
+struct HugePageAllocator {
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef HugePageAllocator<U, Threshold> other;
+	};
+
+	HugePageAllocator() = default;
+
+	template <typename U>
+	HugePageAllocator(const HugePageAllocator<U, Threshold> &) {}
+
+	T * allocate(size_t n) {
+		const size_t bytes = n * sizeof(T);
+		if (bytes < Threshold) {
+			return static_cast<T *>(::operator new(bytes));
+		}
+		void *result = allocateHugePages(bytes);
+		if (!result) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(result);
+	}
+
+	void deallocate(T *data, size_t n) {
+		const size_t bytes = n * sizeof(T);
+		if (bytes < Threshold) {
+			::operator delete(data);
+		} else {
+			freeHugePages(data, bytes);
+		}
+	}
+
+	template <typename U>
+	bool operator==(const HugePageAllocator<U, Threshold> &) const {
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const HugePageAllocator<U, Threshold> &) const {
+		return false;
+	}
+};
@@ -0,0 +1,143 @@
+#include "oo-hash-table.hpp"
+#include "huge-page-allocator.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// Counts data TLB misses of this thread through perf events, reports -1 where they are not available
+/// (other systems, kernel.perf_event_paranoid too high, or virtual machines without a PMU)
+class TlbMissCounter {
+	int fd = -1;
+public:
+	TlbMissCounter() {
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	TlbMissCounter(const TlbMissCounter &) = delete;
+	TlbMissCounter & operator=(const TlbMissCounter &) = delete;
+
+	~TlbMissCounter() {
+#ifdef __linux__
+		if (fd >= 0) {
+			close(fd);
+		}
+#endif
+	}
+
+	void start() {
+#ifdef __linux__
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	/// Misses since start(), -1 if not available
+	long long stop() {
+#ifdef __linux__
+		long long count = 0;
+		if (fd >= 0 && ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) == 0 && read(fd, &count, sizeof(count)) == sizeof(count)) {
+			return count;
+		}
+#endif
+		return -1;
+	}
+};
+
+/// Anonymous memory of the process backed by transparent huge pages in MiB, -1 where it can not be read
+long long anonHugePagesMiB() {
+	long long result = -1;
+#ifdef __linux__
+	if (FILE *smaps = fopen("/proc/self/smaps_rollup", "r")) {
+		char line[256];
+		while (fgets(line, sizeof(line), smaps)) {
+			long long kb;
+			if (sscanf(line, "AnonHugePages: %lld kB", &kb) == 1) {
+				result = kb / 1024;
+			}
+		}
+		fclose(smaps);
+	}
+#endif
+	return result;
+}
+
+/// Fill a table with size random keys and time lookups of random present keys, one result line per table
+template <typename Table>
+void run(const char *name, size_t size, size_t lookups) {
+	std::mt19937_64 rng(size);
+	std::vector<uint64_t> keys(size);
+	for (uint64_t &key : keys) {
+		key = rng();
+	}
+
+	Table table;
+	// sized once, so there is one bucket array and no resize copies it
+	table.reserve(size);
+	for (size_t c = 0; c < size; c++) {
+		table[keys[c]] = c;
+	}
+
+	std::vector<uint32_t> order(lookups);
+	for (uint32_t &idx : order) {
+		idx = uint32_t(rng() % size);
+	}
+
+	TlbMissCounter tlbMisses;
+	uint64_t checksum = 0;
+	tlbMisses.start();
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t c = 0; c < lookups; c++) {
+		checksum += table.find(keys[order[c]])->second;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const long long misses = tlbMisses.stop();
+
+	printf("%s,%zu,%zu,%.1f,%.3f,%lld,%llu\n", name, size, table.bucket_count(), seconds * 1e9 / lookups,
+		misses < 0 ? -1.0 : double(misses) / lookups, anonHugePagesMiB(), (unsigned long long)(checksum % 10));
+	fflush(stdout);
+}
+
+/// Usage: huge-page-bench [size=20000000] [lookups=20000000]
+/// Random lookups into an open addressing table much larger than the TLB reach of 4 KiB pages,
+/// with the bucket array on normal pages and on huge pages. Results go to stdout as csv.
+/// dtlb_misses_per_lookup is -1 without access to perf events, anon_huge_mib is the process total after the fill.
+int main(int argc, char *argv[]) {
+	const size_t size = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+	const size_t lookups = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000000;
+
+	typedef OOHashTable<uint64_t, uint64_t, FastHash<uint64_t>, LinearProber, PowerOfTwoCapacity> NormalPagesTable;
+	typedef OOHashTable<uint64_t, uint64_t, FastHash<uint64_t>, LinearProber, PowerOfTwoCapacity, NoStoredHash,
+		HugePageAllocator<std::pair<uint64_t, uint64_t>>> HugePagesTable;
+
+	printf("pages,size,buckets,ns_per_lookup,dtlb_misses_per_lookup,anon_huge_mib,checksum\n");
+	// each table is destroyed before the next one is built, so only one is resident at a time
+	run<NormalPagesTable>("normal", size, lookups);
+	run<HugePagesTable>("huge", size, lookups);
+	run<NormalPagesTable>("normal", size, lookups);
+	run<HugePagesTable>("huge", size, lookups);
+	return 0;
+}
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+
+#include "capacity-policy.hpp"
+#include "epoch-reclamation.hpp"
+
+/// Non-blocking open addressing hash table for integer keys and integer values
+/// Slots are claimed with CAS on the key and values are updated with CAS, no operation ever takes a lock.
+/// Keys are never removed from a slot, erase leaves a tombstone value which is dropped on the next resize.
+/// Resize is cooperative: a bigger table is linked as next, every writer copies a chunk of slots and a slot
+/// is frozen (moved bit set on its value) before it is copied so no update can be lost. Any thread
+/// can finish copying a frozen slot, so a stalled thread never blocks the others.
+/// Every operation is an EpochDomain read section, a table replaced by its copy is freed once no operation
+/// that could still see it is running. The last freed table is kept as a spare, so a resize that only drops
+/// tombstones re-uses it instead of allocating, and insert/erase churn runs in two tables' memory.
+/// @tparam K - integral key type, EmptyKey is reserved and can not be inserted
+/// @tparam T - integral value type, 64 bit values must be below 2^63 - 2
+template <typename K, typename T, K EmptyKey = std::numeric_limits<K>::max()>
+class LockFreeHashTable {
+	static_assert(std::is_integral<K>::value, "Keys must be integers");
+	static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t), "Values must be integers up to 64 bits");
+
+	typedef typename std::make_unsigned<T>::type unsigned_value;
+
+	/// Raw value states, anything below erased is an encoded value
+	static const uint64_t movedBit = uint64_t(1) << 63; ///< Set when the slot is frozen for copying to the next table
+	static const uint64_t absent = movedBit - 1; ///< Slot never had a value in this table
+	static const uint64_t erased = movedBit - 2; ///< Slot had a value which was erased
+
+	static const size_t copyChunk = 256; ///< Number of slots a writer copies when helping a resize
+
+	struct Slot {
+		std::atomic<K> key;
+		std::atomic<uint64_t> value;
+	};
+
+	struct Table {
+		const size_t capacity; ///< Number of slots, power of two
+		Slot *slots; ///< The slots
+		std::atomic<size_t> claimed; ///< Number of slots with a key
+		std::atomic<Table *> next; ///< Table this one is copied to, nullptr if not resizing
+		std::atomic<size_t> copyIndex; ///< First slot not yet taken by a helping thread
+		std::atomic<size_t> copyDone; ///< Number of slots frozen and copied to next
+		uint64_t retireEpoch; ///< Epoch at which it stopped being current, set once retired
+		Table *nextRetired; ///< Next table in the retired list
+
+		explicit Table(size_t capacity)
+			: capacity(capacity)
+			, slots(new Slot[capacity])
+			, retireEpoch(0)
+			, nextRetired(nullptr)
+		{
+			reset();
+		}
+
+		/// Empty all slots, only while no other thread can reach the table
+		void reset() {
+			for (size_t c = 0; c < capacity; c++) {
+				slots[c].key.store(EmptyKey, std::memory_order_relaxed);
+				slots[c].value.store(absent, std::memory_order_relaxed);
+			}
+			claimed.store(0, std::memory_order_relaxed);
+			next.store(nullptr, std::memory_order_relaxed);
+			copyIndex.store(0, std::memory_order_relaxed);
+			copyDone.store(0, std::memory_order_relaxed);
+		}
+
+		~Table() {
+			delete[] slots;
+		}
+
+		/// Probe this many slots before giving up and resizing
+		size_t reprobeLimit() const {
+			return 16 + capacity / 4;
+		}
+	};
+
+	std::atomic<Table *> current; ///< Table new operations start from
+	std::atomic<Table *> retired; ///< Tables replaced by their copy, freed once no operation can see them
+	std::atomic<Table *> spare; ///< A freed table kept for the next resize to the same capacity, or nullptr
+	std::atomic<size_t> count; ///< Number of live elements, exact only when there are no concurrent writers
+	std::atomic<size_t> allocatedSlots; ///< Slots of all tables not yet deleted
+	std::atomic<uint64_t> scannedEpoch; ///< Safe epoch of the last walk of the retired list
+	EpochDomain &domain; ///< Tracks the running operations
+	PowerOfTwoCapacity sizePolicy; ///< Maps key to slot index
+
+	static uint64_t encode(T value) {
+		const uint64_t raw = uint64_t(unsigned_value(value));
+		assert(raw < erased && "Value collides with reserved states");
+		return raw;
+	}
+
+	static T decode(uint64_t raw) {
+		return T(unsigned_value(raw));
+	}
+
+	/// Find the slot for key in t
+	/// @param claim - if set, claim an empty slot for the key when it is not present
+	/// @param mayResize - if not set, a claim filling t past the load does not start a resize, the next claim will
+	/// @return - the slot or nullptr if key is not in t and it could not (or must not) be claimed
+	Slot * getSlot(Table *t, K key, bool claim, bool mayResize = true) {
+		size_t idx = sizePolicy.index(size_t(key), t->capacity);
+		for (size_t probe = 0; probe < t->reprobeLimit(); ++probe) {
+			Slot &slot = t->slots[idx];
+			K current = slot.key.load(std::memory_order_acquire);
+			if (current == key) {
+				return &slot;
+			}
+
+			if (current == EmptyKey) {
+				// keys are claimed even during resize, so each key has exactly one slot to freeze
+				// before it is written in the next table
+				if (!claim) {
+					return nullptr;
+				}
+				if (slot.key.compare_exchange_strong(current, key)) {
+					if (t->claimed.fetch_add(1) + 1 > t->capacity / 2 && mayResize) {
+						resize(t);
+					}
+					return &slot;
+				}
+				// lost the race, the slot is usable only if the other thread claimed it for the same key
+				if (current == key) {
+					return &slot;
+				}
+			}
+			idx = (idx + 1) & (t->capacity - 1);
+		}
+		return nullptr;
+	}
+
+	/// Start resizing t if not already started, returns the next table
+	Table * resize(Table *t) {
+		Table *next = t->next.load();
+		if (next) {
+			return next;
+		}
+
+		// copy drops tombstones, so only grow if there are enough live elements
+		const size_t live = count.load(std::memory_order_relaxed);
+		const size_t newCapacity = live * 4 >= t->capacity ? sizePolicy.grow(t->capacity) : t->capacity;
+		Table *fresh = allocate(newCapacity);
+		if (t->next.compare_exchange_strong(next, fresh)) {
+			return fresh;
+		}
+		// never published, so it can be the spare right away
+		recycle(fresh);
+		return next;
+	}
+
+	/// Empty table of capacity, the spare if it has that capacity
+	Table * allocate(size_t capacity) {
+		if (!spare.load(std::memory_order_relaxed)) {
+			reclaimRetired();
+		}
+		Table *t = spare.exchange(nullptr, std::memory_order_acquire);
+		if (t && t->capacity == capacity) {
+			t->reset();
+			return t;
+		}
+		destroy(t);
+		allocatedSlots.fetch_add(capacity, std::memory_order_relaxed);
+		return new Table(capacity);
+	}
+
+	void destroy(Table *t) {
+		if (t) {
+			allocatedSlots.fetch_sub(t->capacity, std::memory_order_relaxed);
+			delete t;
+		}
+	}
+
+	/// Keep t, which no thread can reach, as the spare unless there already is one
+	void recycle(Table *t) {
+		Table *empty = nullptr;
+		if (!spare.compare_exchange_strong(empty, t, std::memory_order_release, std::memory_order_relaxed)) {
+			destroy(t);
+		}
+	}
+
+	/// Add t to the retired list once it is no longer current, then free the earlier retired tables that are safe
+	/// The calling operation still sees t, so t itself waits for a later call.
+	void retire(Table *t) {
+		t->retireEpoch = domain.advance();
+		pushRetired(t);
+		reclaimRetired();
+	}
+
+	void pushRetired(Table *t) {
+		Table *head = retired.load(std::memory_order_relaxed);
+		do {
+			t->nextRetired = head;
+		} while (!retired.compare_exchange_weak(head, t, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	/// Take the whole retired list, free the tables retired before every running operation started and put back the rest
+	/// Taking the list with one exchange makes this safe to run from many threads. While an operation stays pinned,
+	/// e.g. its thread is preempted, the list grows with every resize, so it is only walked once the safe epoch moved.
+	/// @param always - walk the list even if the safe epoch did not move, a table retired during the last walk may be freed
+	void reclaimRetired(bool always = false) {
+		const uint64_t safe = domain.safeEpoch();
+		if (safe == scannedEpoch.exchange(safe, std::memory_order_relaxed) && !always) {
+			return;
+		}
+		Table *list = retired.exchange(nullptr, std::memory_order_acquire);
+		while (list) {
+			Table *t = list;
+			list = t->nextRetired;
+			if (t->retireEpoch < safe) {
+				recycle(t);
+			} else {
+				pushRetired(t);
+			}
+		}
+	}
+
+	/// Copy a chunk of not yet taken slots from t to its next table
+	void helpCopy(Table *t) {
+		const size_t start = t->copyIndex.fetch_add(copyChunk);
+		for (size_t c = start; c < start + copyChunk && c < t->capacity; c++) {
+			copySlot(t, t->slots[c]);
+		}
+	}
+
+	/// Freeze the slot and copy its value to the next table, safe to call from many threads for the same slot
+	/// @param mayResize - if not set, give up the copy instead of resizing the next table, only for slots another thread froze
+	void copySlot(Table *t, Slot &slot, bool mayResize = true) {
+		uint64_t raw = slot.value.load();
+		bool frozeIt = false;
+		while (!(raw & movedBit)) {
+			if (slot.value.compare_exchange_weak(raw, raw | movedBit)) {
+				raw |= movedBit;
+				frozeIt = true;
+			}
+		}
+
+		assert((mayResize || !frozeIt) && "The thread freezing a slot must finish its copy");
+
+		const uint64_t frozen = raw & ~movedBit;
+		if (frozen < erased) {
+			// a value is set only after the key is claimed
+			putIfAbsent(t->next.load(), slot.key.load(), frozen, mayResize);
+		}
+
+		// only the thread that froze the slot counts it, so each slot is counted once
+		if (frozeIt && t->copyDone.fetch_add(1) + 1 == t->capacity) {
+			promote(t);
+		}
+	}
+
+	/// Copy a value from the previous table, does nothing if the key already got a value in t
+	/// Writers copy the key's old slot before touching it in t, so an existing value is always newer
+	/// @param mayResize - if not set, return without copying when t has no room and no next table
+	void putIfAbsent(Table *t, K key, uint64_t raw, bool mayResize) {
+		while (true) {
+			Slot *slot = getSlot(t, key, true, mayResize);
+			if (!slot) {
+				Table *next = t->next.load();
+				if (!next && !mayResize) {
+					return;
+				}
+				t = next ? next : resize(t);
+				continue;
+			}
+
+			uint64_t expected = absent;
+			if (slot->value.compare_exchange_strong(expected, raw) || expected != (absent | movedBit)) {
+				// stored, or t got a newer value which the thread that froze the slot carries to the next table
+				return;
+			}
+
+			// t itself is being copied and the slot was frozen before it got a value, nobody else copies the key
+			t = t->next.load();
+		}
+	}
+
+	/// Make the next table current after t is fully copied, skipping any following tables that finished first
+	/// Only the thread replacing a table retires it, so each table is retired once.
+	void promote(Table *t) {
+		Table *expected = t;
+		while (expected->copyDone.load() == expected->capacity) {
+			Table *next = expected->next.load();
+			if (!current.compare_exchange_strong(expected, next)) {
+				break;
+			}
+			retire(expected);
+			expected = next;
+		}
+	}
+
+	/// Apply fn to the raw value of key and return the previous raw value
+	/// @param claim - if set, claim a slot if key is not present, otherwise return absent
+	/// @param fn - maps current raw value (possibly absent or erased) to the new one, called again on CAS failure
+	template <typename Update>
+	uint64_t update(K key, bool claim, Update fn) {
+		EpochGuard guard(domain);
+		Table *t = current.load();
+		while (true) {
+			if (t->next.load()) {
+				helpCopy(t);
+			}
+
+			Slot *slot = getSlot(t, key, claim);
+			if (!slot) {
+				Table *next = t->next.load();
+				if (!next && !claim) {
+					return absent;
+				}
+				t = next ? next : resize(t);
+				continue;
+			}
+
+			uint64_t raw = slot->value.load();
+			while (!(raw & movedBit)) {
+				const uint64_t desired = fn(raw);
+				if (desired == raw || slot->value.compare_exchange_weak(raw, desired)) {
+					return raw;
+				}
+			}
+
+			// the slot is being moved, make sure its value is in the next table before updating it there
+			copySlot(t, *slot);
+			t = t->next.load();
+		}
+	}
+
+public:
+	typedef K key_type;
+	typedef T value_type;
+
+	/// Create table with given initial capacity, rounded up to power of two
+	explicit LockFreeHashTable(size_t capacity = 64)
+		: current(nullptr)
+		, retired(nullptr)
+		, spare(nullptr)
+		, count(0)
+		, allocatedSlots(0)
+		, scannedEpoch(0)
+		, domain(EpochDomain::instance())
+	{
+		current.store(allocate(sizePolicy.initial(capacity)));
+	}
+
+	LockFreeHashTable(const LockFreeHashTable &) = delete;
+	LockFreeHashTable & operator=(const LockFreeHashTable &) = delete;
+
+	/// There must be no operations left, all tables are freed right away
+	~LockFreeHashTable() {
+		for (Table *t = current.load(); t; ) {
+			Table *next = t->next.load();
+			destroy(t);
+			t = next;
+		}
+		for (Table *t = retired.load(); t; ) {
+			Table *next = t->nextRetired;
+			destroy(t);
+			t = next;
+		}
+		destroy(spare.load());
+	}
+
+	/// Copy the value for key into value, returns false if key is not present
+	/// Never blocks and never resizes. A slot frozen by a resize holds the key's value until the next table
+	/// gets one, the copy is finished on the way if the next table has room for it.
+	bool find(K key, T &value) {
+		assert(key != EmptyKey && "Reserved key");
+		EpochGuard guard(domain);
+		uint64_t latest = absent; ///< Value of the last frozen slot passed, current unless a later table has one
+		for (Table *t = current.load(); t; t = t->next.load()) {
+			Slot *slot = getSlot(t, key, false);
+			if (!slot) {
+				// not in this table, but could be already inserted in the next one
+				continue;
+			}
+
+			const uint64_t raw = slot->value.load();
+			if (raw & movedBit) {
+				latest = raw & ~movedBit;
+				copySlot(t, *slot, false);
+				continue;
+			}
+
+			// absent means the key is claimed but its copy or insert is not done, the frozen value still holds
+			if (raw != absent) {
+				latest = raw;
+			}
+			break;
+		}
+
+		if (latest >= erased) {
+			return false;
+		}
+		value = decode(latest);
+		return true;
+	}
+
+	/// Insert key-value pair, overwrites the value if key is present
+	/// Returns true if the key was not present before
+	bool insert(K key, T value) {
+		assert(key != EmptyKey && "Reserved key");
+		const uint64_t raw = encode(value);
+		const uint64_t previous = update(key, true, [raw](uint64_t) {
+			return raw;
+		});
+		if (previous >= erased) {
+			++count;
+			return true;
+		}
+		return false;
+	}
+
+	/// Atomically add delta to the value of key, missing key is treated as 0, returns the new value
+	T add(K key, T delta) {
+		assert(key != EmptyKey && "Reserved key");
+		const uint64_t previous = update(key, true, [delta](uint64_t old) {
+			return encode(old >= erased ? delta : T(decode(old) + delta));
+		});
+		if (previous >= erased) {
+			++count;
+			return delta;
+		}
+		return T(decode(previous) + delta);
+	}
+
+	/// Erase element by key, returns true if it was present
+	bool erase(K key) {
+		assert(key != EmptyKey && "Reserved key");
+		const uint64_t previous = update(key, false, [](uint64_t old) {
+			return old >= erased ? old : erased;
+		});
+		if (previous < erased) {
+			--count;
+			return true;
+		}
+		return false;
+	}
+
+	/// Get the number of key-value pairs, exact only if there are no concurrent modifications
+	size_t size() const {
+		return count.load();
+	}
+
+	/// Number of slots of the current table
+	size_t bucket_count() const {
+		return current.load()->capacity;
+	}
+
+	/// Number of slots of all allocated tables: current, resize targets, retired tables not yet freed and the spare
+	size_t allocated_slots() const {
+		return allocatedSlots.load(std::memory_order_relaxed);
+	}
+
+	/// Free the replaced tables no operation can see anymore
+	/// Resizes do this too, call it when writes stop so the last replaced tables are not kept until the next one
+	void reclaim() {
+		reclaimRetired(true);
+	}
+};
@@ -0,0 +1,130 @@
+#include "co-hash-table.hpp"
+#include "lru-cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/// The baseline - COHashTable from key to a std::list node holding the element, behind one global mutex
+/// A hit is a lookup and a splice, an insert is a lookup, a list node allocation and a second lookup to insert.
+template <typename K, typename V>
+class ListLruCache {
+	typedef std::list<std::pair<K, V>> list_type;
+	COHashTable<K, typename list_type::iterator> index;
+	list_type order; ///< Most recently used first
+	size_t capacity;
+	std::mutex mtx;
+public:
+	explicit ListLruCache(size_t capacity)
+		: capacity(capacity) {}
+
+	bool get(const K &key, V &value) {
+		std::lock_guard<std::mutex> lock(mtx);
+		typename COHashTable<K, typename list_type::iterator>::iterator it = index.find(key);
+		if (it == index.end()) {
+			return false;
+		}
+		order.splice(order.begin(), order, it->second);
+		value = it->second->second;
+		return true;
+	}
+
+	bool put(const K &key, const V &value) {
+		std::lock_guard<std::mutex> lock(mtx);
+		typename COHashTable<K, typename list_type::iterator>::iterator it = index.find(key);
+		if (it != index.end()) {
+			it->second->second = value;
+			order.splice(order.begin(), order, it->second);
+			return false;
+		}
+		order.emplace_front(key, value);
+		index.insert(key, order.begin());
+		if (order.size() > capacity) {
+			index.erase(order.back().first);
+			order.pop_back();
+		}
+		return true;
+	}
+};
+
+/// Run opsPerThread get calls on each of threadCount threads, putting the key after every miss
+/// hitPercent of the keys come from a hot set filling 80% of the capacity, the rest are never seen before,
+/// so the hit rate settles near hitPercent once the hot set is cached. Returns million operations per second.
+template <typename Cache>
+double runCache(Cache &cache, int threadCount, size_t capacity, int opsPerThread, int hitPercent, double &hitRate) {
+	std::vector<std::thread> threads;
+	std::vector<long long> hits(threadCount);
+	const int hotKeys = int(capacity * 8 / 10);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&cache, &hits, t, hotKeys, opsPerThread, hitPercent]() {
+			std::mt19937 rng(t);
+			int coldKey = hotKeys + t * opsPerThread;
+			long long found = 0;
+			for (int c = 0; c < opsPerThread; c++) {
+				const unsigned r = rng();
+				const int key = int(r >> 24) % 100 < hitPercent ? int(r % unsigned(hotKeys)) : coldKey++;
+				int value;
+				if (cache.get(key, value)) {
+					++found;
+				} else {
+					cache.put(key, key);
+				}
+			}
+			hits[t] = found;
+		});
+	}
+	for (std::thread &th : threads) {
+		th.join();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	long long total = 0;
+	for (long long found : hits) {
+		total += found;
+	}
+	hitRate = double(total) / (double(threadCount) * opsPerThread);
+	return double(threadCount) * opsPerThread / elapsed.count() / 1e6;
+}
+
+/// Fill the hot set, then run the mix
+template <typename Cache>
+double warmAndRun(Cache &cache, int threadCount, size_t capacity, int opsPerThread, int hitPercent, double &hitRate) {
+	for (int c = 0; c < int(capacity * 8 / 10); c++) {
+		cache.put(c, c);
+	}
+	return runCache(cache, threadCount, capacity, opsPerThread, hitPercent, hitRate);
+}
+
+/// Usage: lru-cache-bench [maxThreads] [capacity] [opsPerThread] [hitPercent]
+int main(int argc, char *argv[]) {
+	const int maxThreads = argc > 1 ? atoi(argv[1]) : 32;
+	const size_t capacity = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+	const int opsPerThread = argc > 3 ? atoi(argv[3]) : 2000000;
+	const int hitPercent = argc > 4 ? atoi(argv[4]) : 95;
+
+	printf("capacity %zu, ops per thread %d, hot keys %d%%, hardware threads %u\n",
+		capacity, opsPerThread, hitPercent, std::thread::hardware_concurrency());
+	printf("%8s %14s %14s %14s %8s %8s\n", "threads", "list Mops/s", "lru Mops/s", "clock Mops/s", "lru", "clock");
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		double listHits, lruHits, clockHits;
+		ListLruCache<int, int> list(capacity);
+		const double listOps = warmAndRun(list, threads, capacity, opsPerThread, hitPercent, listHits);
+		LruCache<int, int, std::hash<int>, LruEviction> lru(capacity);
+		const double lruOps = warmAndRun(lru, threads, capacity, opsPerThread, hitPercent, lruHits);
+		LruCache<int, int, std::hash<int>, ClockEviction> clock(capacity);
+		const double clockOps = warmAndRun(clock, threads, capacity, opsPerThread, hitPercent, clockHits);
+
+		printf("%8d %14.2f %14.2f %14.2f %7.2fx %7.2fx\n", threads, listOps, lruOps, clockOps, lruOps / listOps, clockOps / listOps);
+		printf("%8s %13.1f%% %13.1f%% %13.1f%%\n", "hit rate", listHits * 100, lruHits * 100, clockHits * 100);
+	}
+
+	return 0;
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "capacity-policy.hpp"
+
+/// Least recently used eviction: every hit moves the entry to the front of its shard's recency list
+/// Moving writes the links of the entry and of its old and new neighbours, usually three cache misses on a big cache.
+struct LruEviction {
+	enum : bool { promoteOnHit = true };
+};
+
+/// CLOCK (second chance) eviction: a hit only sets the referenced bit of the entry it already read, the list is not touched
+/// The hand walks the entries in insertion order, clears the bits it passes and evicts the first entry that was not
+/// referenced since the hand last passed it.
+struct ClockEviction {
+	enum : bool { promoteOnHit = false };
+};
+
+/// Every element costs 1, the cache capacity is a number of entries
+struct UnitCharge {
+	template <typename K, typename V>
+	size_t operator()(const K &, const V &) const {
+		return 1;
+	}
+};
+
+/// Elements cost their size in bytes, the cache capacity is a memory budget
+/// Counts the heap memory of strings and vectors, other types are charged sizeof only.
+struct ByteCharge {
+	template <typename K, typename V>
+	size_t operator()(const K &key, const V &value) const {
+		return bytes(key) + bytes(value);
+	}
+
+	template <typename X>
+	static size_t bytes(const X &) {
+		return sizeof(X);
+	}
+
+	static size_t bytes(const std::string &value) {
+		return sizeof(value) + value.capacity();
+	}
+
+	template <typename X>
+	static size_t bytes(const std::vector<X> &value) {
+		return sizeof(value) + value.capacity() * sizeof(X);
+	}
+};
+
+/// Counters of a cache, summed over its shards
+struct CacheStats {
+	uint64_t hits = 0; ///< get calls that found the key
+	uint64_t misses = 0; ///< get calls that did not
+	uint64_t evictions = 0; ///< Entries removed to make room, not counting erase and clear
+	size_t size = 0; ///< Number of entries
+	size_t charge = 0; ///< Sum of the entries' charges
+
+	double hitRate() const {
+		return hits + misses ? double(hits) / (hits + misses) : 0;
+	}
+};
+
+/// Bounded thread safe cache evicting by recency, see LruEviction and ClockEviction
+/// Keys are split across Shards independent shards by hash, each with its own lock and an equal part
+/// of the capacity, so the eviction order is per shard. Each shard keeps its entries in one array like PoolHashTable:
+/// bucket chains and the recency list are both 32 bit indices inside the entries, so a hit is one lookup and inserting
+/// allocates nothing once the array has reached the capacity.
+/// Charge gives the cost of an element, UnitCharge for a capacity in entries or ByteCharge for one in bytes.
+/// It is called again when an element is removed, so it must give the same cost for an unchanged element.
+/// An element costing more than its shard's capacity evicts everything else and stays alone.
+/// There are no iterators since they would outlive the lock, values are copied out instead.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eviction = LruEviction, typename Charge = UnitCharge, size_t Shards = 16>
+class LruCache {
+	static_assert(Shards > 0, "Need at least one shard");
+public:
+	typedef K key_type;
+	typedef V value_type;
+private:
+	typedef std::pair<K, V> pair_type;
+
+	enum : uint32_t {
+		npos = 0x7FFFFFFF, ///< No entry, ends a chain, the free list or marks an empty recency list
+		freeBit = 0x80000000, ///< Set in next of entries that are in the free list
+	};
+
+	struct Entry {
+		pair_type data; ///< Key value pair, default constructed while free
+		uint32_t next; ///< Next entry in the bucket chain, or freeBit | next free entry
+		uint32_t older; ///< Previous entry in the circular recency list
+		uint32_t newer; ///< Next entry in the circular recency list, the newest entry's is the oldest one
+		bool referenced; ///< Hit since the clock hand last passed, only for ClockEviction
+
+		Entry(const K &key, const V &value)
+			: data(key, value)
+			, next(npos)
+			, older(npos)
+			, newer(npos)
+			, referenced(false) {}
+
+		bool isFree() const {
+			return next & freeBit;
+		}
+	};
+
+	/// Shards are aligned to separate cache lines so a lock taken on one does not invalidate its neighbours
+	/// Every access takes the mutex, hits write the recency or the referenced bit and the counters. A reader-writer lock
+	/// would not let hits on one shard run in parallel either, its shared count is a write to the same cache line.
+	struct alignas(64) Shard {
+		mutable std::mutex mtx; ///< Protects the shard
+		std::vector<Entry> entries; ///< All entries, used and free
+		std::vector<uint32_t> heads; ///< Index of the first entry of each bucket chain
+		uint32_t freeList = npos; ///< First free entry
+		uint32_t newest = npos; ///< Most recently inserted or promoted entry, its newer link is the oldest entry
+		size_t count = 0; ///< Number of entries in use
+		size_t charge = 0; ///< Sum of the charges of the used entries
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	mutable Shard shards[Shards]; ///< The shards, mutable since hits update recency and counters
+	size_t shardCapacity; ///< Capacity of each shard
+	Hash hasher; ///< The hash functor
+	Charge charger; ///< Cost of an element
+	PowerOfTwoCapacity sizePolicy; ///< Bucket count of the chains and mapping of hashes to buckets
+
+	/// Select shard by the high bits of the mixed hash, the shard's buckets are indexed with the low bits
+	Shard & getShard(size_t hash) const {
+		return shards[(PowerOfTwoCapacity::mix(hash) >> 32) % Shards];
+	}
+
+	/// Entry holding key or npos
+	uint32_t findEntry(const Shard &shard, const K &key, size_t hash) const {
+		if (shard.heads.empty()) {
+			return npos;
+		}
+		for (uint32_t idx = shard.heads[sizePolicy.index(hash, shard.heads.size())]; idx != npos; idx = shard.entries[idx].next) {
+			const Entry &entry = shard.entries[idx];
+			if (entry.data.first == key) {
+				return idx;
+			}
+		}
+		return npos;
+	}
+
+	/// Make idx the newest entry of the recency list, it must not be in the list
+	static void linkNewest(Shard &shard, uint32_t idx) {
+		Entry &entry = shard.entries[idx];
+		if (shard.newest == npos) {
+			entry.older = entry.newer = idx;
+		} else {
+			Entry &newest = shard.entries[shard.newest];
+			entry.older = shard.newest;
+			entry.newer = newest.newer;
+			shard.entries[newest.newer].older = idx;
+			newest.newer = idx;
+		}
+		shard.newest = idx;
+	}
+
+	/// Remove idx from the recency list
+	static void unlinkRecency(Shard &shard, uint32_t idx) {
+		Entry &entry = shard.entries[idx];
+		if (entry.newer == idx) {
+			shard.newest = npos;
+			return;
+		}
+		shard.entries[entry.older].newer = entry.newer;
+		shard.entries[entry.newer].older = entry.older;
+		if (shard.newest == idx) {
+			shard.newest = entry.older;
+		}
+	}
+
+	/// Re-link all used entries into twice the buckets
+	void growBuckets(Shard &shard) {
+		shard.heads.assign(shard.heads.empty() ? sizePolicy.initial(16) : sizePolicy.grow(shard.heads.size()), npos);
+		for (uint32_t idx = 0; idx < shard.entries.size(); idx++) {
+			Entry &entry = shard.entries[idx];
+			if (!entry.isFree()) {
+				uint32_t &head = shard.heads[sizePolicy.index(hasher(entry.data.first), shard.heads.size())];
+				entry.next = head;
+				head = idx;
+			}
+		}
+	}
+
+	/// Charge of a stored element, computed again instead of stored so entries stay small
+	/// It is the charge of the copy in the entry, e.g. its string capacity, so adding and removing it always match
+	size_t chargeOf(const Entry &entry) const {
+		return charger(entry.data.first, entry.data.second);
+	}
+
+	/// Store a new element in a free or new entry, link it in its chain and as the newest entry
+	void allocate(Shard &shard, size_t hash, const K &key, const V &value) {
+		if (shard.count >= shard.heads.size()) {
+			growBuckets(shard);
+		}
+		uint32_t idx;
+		if (shard.freeList != npos) {
+			idx = shard.freeList;
+			Entry &entry = shard.entries[idx];
+			shard.freeList = entry.next & ~uint32_t(freeBit);
+			entry.data.first = key;
+			entry.data.second = value;
+			entry.referenced = false;
+		} else {
+			assert(shard.entries.size() < npos && "Entry index does not fit in 31 bits");
+			idx = uint32_t(shard.entries.size());
+			shard.entries.emplace_back(key, value);
+		}
+
+		uint32_t &head = shard.heads[sizePolicy.index(hash, shard.heads.size())];
+		shard.entries[idx].next = head;
+		head = idx;
+		linkNewest(shard, idx);
+		++shard.count;
+		shard.charge += chargeOf(shard.entries[idx]);
+	}
+
+	/// Unlink idx from its chain and the recency list and put it in the free list
+	void release(Shard &shard, uint32_t idx) {
+		Entry &entry = shard.entries[idx];
+		uint32_t *link = &shard.heads[sizePolicy.index(hasher(entry.data.first), shard.heads.size())];
+		while (*link != idx) {
+			link = &shard.entries[*link].next;
+		}
+		*link = entry.next;
+		unlinkRecency(shard, idx);
+
+		shard.charge -= chargeOf(entry);
+		--shard.count;
+		// release any resources held by the pair
+		entry.data = pair_type();
+		entry.next = shard.freeList | freeBit;
+		shard.freeList = idx;
+	}
+
+	/// Entry to evict next, never keep, the shard must have another entry
+	static uint32_t pickVictim(Shard &shard, uint32_t keep) {
+		for (;;) {
+			const uint32_t oldest = shard.entries[shard.newest].newer;
+			if (oldest != keep) {
+				if (Eviction::promoteOnHit || !shard.entries[oldest].referenced) {
+					return oldest;
+				}
+				shard.entries[oldest].referenced = false;
+			}
+			// moving the newest mark one entry forward is the clock hand passing the oldest entry
+			shard.newest = oldest;
+		}
+	}
+
+	/// Evict entries other than keep until incoming more charge fits in the capacity
+	void evictFor(Shard &shard, size_t incoming, uint32_t keep) {
+		const size_t kept = keep == npos ? 0 : 1;
+		while (shard.count > kept && shard.charge + incoming > shardCapacity) {
+			release(shard, pickVictim(shard, keep));
+			++shard.evictions;
+		}
+	}
+
+public:
+	/// capacity is in the units of Charge and split evenly over the shards, each shard holds at least one element
+	explicit LruCache(size_t capacity, Hash hash = Hash(), Charge charge = Charge())
+		: shardCapacity(capacity / Shards ? capacity / Shards : 1)
+		, hasher(hash)
+		, charger(charge) {}
+
+	LruCache(const LruCache &) = delete;
+	LruCache & operator=(const LruCache &) = delete;
+
+	/// Copy the value for key into value and mark the entry as recently used, returns false if key is not present
+	bool get(const K &key, V &value) {
+		const size_t hash = hasher(key);
+		Shard &shard = getShard(hash);
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		const uint32_t idx = findEntry(shard, key, hash);
+		if (idx == npos) {
+			++shard.misses;
+			return false;
+		}
+		++shard.hits;
+		Entry &entry = shard.entries[idx];
+		if constexpr (Eviction::promoteOnHit) {
+			if (idx != shard.newest) {
+				unlinkRecency(shard, idx);
+				linkNewest(shard, idx);
+			}
+		} else {
+			entry.referenced = true;
+		}
+		value = entry.data.second;
+		return true;
+	}
+
+	/// Check if key is cached, without counting a hit or miss or changing the recency
+	bool contains(const K &key) const {
+		const size_t hash = hasher(key);
+		Shard &shard = getShard(hash);
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		return findEntry(shard, key, hash) != npos;
+	}
+
+	/// Insert key-value pair as the most recently used entry, evicting as needed, overwrites the value if key is present
+	/// Returns true if the key was not present before
+	bool put(const K &key, const V &value) {
+		const size_t hash = hasher(key);
+		Shard &shard = getShard(hash);
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		const uint32_t idx = findEntry(shard, key, hash);
+		if (idx != npos) {
+			Entry &entry = shard.entries[idx];
+			shard.charge -= chargeOf(entry);
+			entry.data.second = value;
+			shard.charge += chargeOf(entry);
+			if constexpr (Eviction::promoteOnHit) {
+				unlinkRecency(shard, idx);
+				linkNewest(shard, idx);
+			} else {
+				entry.referenced = true;
+			}
+			evictFor(shard, 0, idx);
+			return false;
+		}
+
+		evictFor(shard, charger(key, value), npos);
+		allocate(shard, hash, key, value);
+		return true;
+	}
+
+	/// Erase element by key, returns true if it was present
+	bool erase(const K &key) {
+		const size_t hash = hasher(key);
+		Shard &shard = getShard(hash);
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		const uint32_t idx = findEntry(shard, key, hash);
+		if (idx == npos) {
+			return false;
+		}
+		release(shard, idx);
+		return true;
+	}
+
+	/// Remove all elements and free the entries, counters are kept
+	void clear() {
+		for (Shard &shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			std::vector<Entry>().swap(shard.entries);
+			std::vector<uint32_t>().swap(shard.heads);
+			shard.freeList = shard.newest = npos;
+			shard.count = shard.charge = 0;
+		}
+	}
+
+	/// Capacity of all shards together
+	size_t capacity() const {
+		return shardCapacity * Shards;
+	}
+
+	/// Get the number of cached elements, exact only if there are no concurrent modifications
+	size_t size() const {
+		size_t result = 0;
+		for (Shard &shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			result += shard.count;
+		}
+		return result;
+	}
+
+	/// Counters and occupancy, exact only if there are no concurrent operations
+	CacheStats stats() const {
+		CacheStats result;
+		for (Shard &shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			result.hits += shard.hits;
+			result.misses += shard.misses;
+			result.evictions += shard.evictions;
+			result.size += shard.count;
+			result.charge += shard.charge;
+		}
+		return result;
+	}
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Read-only memory mapping of a whole file
+/// Pages are shared with every other process mapping the same file and are read from disk on first access
+class MappedFile {
+	const void *data; ///< Start of the mapping, nullptr if nothing is mapped
+	size_t length; ///< Size of the file and the mapping
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+
+	void reset() {
+		data = nullptr;
+		length = 0;
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = nullptr;
+#endif
+	}
+public:
+	MappedFile() {
+		reset();
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other) {
+		reset();
+		swap(other);
+	}
+
+	MappedFile & operator=(MappedFile &&other) {
+		close();
+		swap(other);
+		return *this;
+	}
+
+	~MappedFile() {
+		close();
+	}
+
+	void swap(MappedFile &other) {
+		std::swap(data, other.data);
+		std::swap(length, other.length);
+#ifdef _WIN32
+		std::swap(file, other.file);
+		std::swap(mapping, other.mapping);
+#endif
+	}
+
+	/// Map the file at path, returns false if it can not be opened or is empty
+	bool open(const char *path) {
+		close();
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER fileSize;
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			close();
+			return false;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data) {
+			close();
+			return false;
+		}
+		length = size_t(fileSize.QuadPart);
+#else
+		const int fd = ::open(path, O_RDONLY);
+		if (fd == -1) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			void *mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			if (mapped != MAP_FAILED) {
+				data = mapped;
+				length = size_t(st.st_size);
+			}
+		}
+		// the mapping keeps the file alive
+		::close(fd);
+#endif
+		return data != nullptr;
+	}
+
+	void close() {
+#ifdef _WIN32
+		if (data) {
+			UnmapViewOfFile(data);
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+#else
+		if (data) {
+			munmap(const_cast<void *>(data), length);
+		}
+#endif
+		reset();
+	}
+
+	const void * bytes() const {
+		return data;
+	}
+
+	size_t size() const {
+		return length;
+	}
+};
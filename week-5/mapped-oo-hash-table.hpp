@@ -0,0 +1,183 @@
+#pragma once
+
+#include "oo-hash-table.hpp"
+#include "hash-table-snapshot.hpp"
+#include "mapped-file.hpp"
+
+/// Read-only view of a file written by OOHashTable::save, lookups and iteration read the mapped buckets directly
+/// Opening only validates the header, so the cost of a load is the page faults taken by the lookups after it.
+/// Processes mapping the same file share the physical pages.
+/// Usually named through OOHashTable<...>::mapped so the template arguments match the saved table.
+template <typename K, typename T, typename Hash, typename IndexProbe, typename Capacity, typename HashStore>
+class MappedOOHashTable {
+	typedef OOHashTable<K, T, Hash, IndexProbe, Capacity, HashStore> table_type;
+	typedef typename table_type::Bucket Bucket;
+public:
+	typedef typename table_type::pair_type pair_type;
+
+	typedef K key_type;
+	typedef T value_type;
+private:
+	MappedFile file; ///< The mapping, owns the memory of buckets
+	const Bucket *buckets; ///< First bucket, right after the header
+	size_t bucketCount; ///< Number of buckets
+	size_t count; ///< Number of elements
+	Hash hasher; ///< Must hash the same as the hasher of the saved table
+	IndexProbe nextIndex; ///< Functor to access next index
+	Capacity sizePolicy; ///< Maps hashes to buckets
+
+	/// Find the index of the bucket holding key or bucketCount if key is not in the table, same probing as OOHashTable::findIndex
+	template <typename Key>
+	size_t findIndex(const Key &key) const {
+		// a table saved before its first insert has no buckets
+		if (!bucketCount) {
+			return 0;
+		}
+		const size_t hash = hasher(key);
+		size_t idx = sizePolicy.index(hash, bucketCount);
+		const size_t probeHash = probeStart(nextIndex, bucketCount, hash);
+		for (size_t step = 1; ; step++) {
+			const Bucket &bucket = buckets[idx];
+			if (bucket.empty && !bucket.deleted) {
+				return bucketCount;
+			}
+			if (!bucket.empty && table_type::bucketMatches(bucket, hash, key)) {
+				return idx;
+			}
+			idx = probeNext(nextIndex, idx, bucketCount, probeHash, step);
+		}
+	}
+
+	/// Enables the heterogeneous lookup overloads only for transparent hashers
+	template <typename Key, typename H>
+	using enable_transparent = typename std::enable_if<IsTransparent<H>::value && !std::is_same<Key, K>::value, int>::type;
+
+public:
+	MappedOOHashTable(Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: buckets(nullptr)
+		, bucketCount(0)
+		, count(0)
+		, hasher(hash)
+		, nextIndex(probe)
+		, sizePolicy(capacity) {}
+
+	/// Map a snapshot, returns false if the file can not be mapped or was not saved by this table type
+	bool open(const char *path) {
+		close();
+		if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) {
+			close();
+			return false;
+		}
+
+		const SnapshotHeader &header = *static_cast<const SnapshotHeader *>(file.bytes());
+		if (!header.matches(hashSeed(hasher), HashStore::snapshotFlag, sizeof(Bucket), sizeof(K), sizeof(T), file.size())) {
+			close();
+			return false;
+		}
+
+		buckets = reinterpret_cast<const Bucket *>(static_cast<const char *>(file.bytes()) + header.headerSize);
+		bucketCount = size_t(header.capacity);
+		count = size_t(header.count);
+		return true;
+	}
+
+	/// Unmap the file, the view becomes empty
+	void close() {
+		file.close();
+		buckets = nullptr;
+		bucketCount = 0;
+		count = 0;
+	}
+
+	bool isOpen() const {
+		return buckets != nullptr;
+	}
+
+	/// Iterator over the key-value pairs in the mapping
+	class iterator {
+		friend class MappedOOHashTable;
+		const Bucket *element; ///< Current bucket
+		const Bucket *last; ///< One past the last bucket
+
+		iterator(const Bucket *element, const Bucket *last)
+			: element(element)
+			, last(last)
+		{
+			validateIterator();
+		}
+
+		/// Skip empty and deleted buckets
+		void validateIterator() {
+			while (element != last && element->empty) {
+				++element;
+			}
+		}
+	public:
+		const pair_type & operator*() const {
+			return element->data;
+		}
+
+		const pair_type * operator->() const {
+			return &element->data;
+		}
+
+		iterator& operator++() {
+			++element;
+			validateIterator();
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		bool operator==(const iterator &other) const {
+			return element == other.element;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	iterator begin() const {
+		return iterator(buckets, buckets + bucketCount);
+	}
+
+	iterator end() const {
+		return iterator(buckets + bucketCount, buckets + bucketCount);
+	}
+
+	/// Find an element by its key, returns iterator to the element or end() if not found
+	iterator find(const K &key) const {
+		assert(isOpen());
+		return iterator(buckets + findIndex(key), buckets + bucketCount);
+	}
+
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	iterator find(const Key &key) const {
+		assert(isOpen());
+		return iterator(buckets + findIndex(key), buckets + bucketCount);
+	}
+
+	bool contains(const K &key) const {
+		assert(isOpen());
+		return findIndex(key) != bucketCount;
+	}
+
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	bool contains(const Key &key) const {
+		assert(isOpen());
+		return findIndex(key) != bucketCount;
+	}
+
+	size_t bucket_count() const {
+		return bucketCount;
+	}
+
+	size_t size() const {
+		return count;
+	}
+};
@@ -3,19 +3,37 @@
 #include <vector>
 #include <unordered_map>
 #include <cassert>
-
-struct LinearProber {
-	int operator() (int index, int size) const {
-		return (index + 1) % size;
-	}
-};
-
-
-/// Open addressing hash table, templated by key, value, hash functor and function for probing on collision
-/// Also the IndexProbe must not have fixed point
-template <typename K, typename T, typename Hash = std::hash<K>, typename IndexProbe = LinearProber>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "capacity-policy.hpp"
+#include "probers.hpp"
+#include "hashers.hpp"
+#include "hash-table-snapshot.hpp"
+#include "prefetch.hpp"
+#include "hash-table-stats.hpp"
+#include "parallel-for-each.hpp"
+
+template <typename K, typename T, typename Hash, typename IndexProbe, typename Capacity, typename HashStore>
+class MappedOOHashTable;
+
+
+/// Open addressing hash table, templated by key, value, hash functor, function for probing on collision and capacity policy
+/// IndexProbe must visit every bucket for the sizes Capacity produces, checked with ProbeCoverage at compile time
+/// If Hash declares is_transparent, find, erase and contains accept any type comparable with K
+/// HashStore decides if each bucket keeps the hash of its key, see StoredHash
+/// Allocator is rebound to the bucket type, HugePageAllocator puts big bucket arrays on huge pages
+template <typename K, typename T, typename Hash = std::hash<K>, typename IndexProbe = LinearProber, typename Capacity = ModuloCapacity,
+	typename HashStore = NoStoredHash, typename Allocator = std::allocator<std::pair<K, T>>>
 class OOHashTable
 {
+	static_assert(ProbeCoverage<IndexProbe, Capacity>::value,
+		"IndexProbe does not reach every bucket with this Capacity, lookups could loop forever; specialize ProbeCoverage if it does");
 public:
 	typedef std::pair<K, T> pair_type;
 
@@ -23,83 +41,251 @@ public:
 	typedef T value_type;
 
 	typedef value_type & reference;
+
+	/// Read-only view of a file written by save(), defined in mapped-oo-hash-table.hpp
+	typedef MappedOOHashTable<K, T, Hash, IndexProbe, Capacity, HashStore> mapped;
 private:
-	
-	struct Bucket {
+	friend mapped;
+
+	/// The hash storage is an empty base unless HashStore keeps the hash
+	struct Bucket : HashStore::Slot {
 		pair_type data; ///< Key value pair
 		bool empty = true; ///< true for empty or deleted buckets
 		bool deleted = false; ///< true when element was removed - can be re-used in insert
 	};
 
-	typedef std::vector<Bucket> table_t;
+	typedef std::vector<Bucket, typename std::allocator_traits<Allocator>::template rebind_alloc<Bucket>> table_t;
 	typedef typename table_t::iterator bucket_iterator;
 
-	table_t table; ///< The table data
-	int count; ///< Actual number of elements
+	table_t table; ///< The table data, no buckets until the first insert
+	size_t count; ///< Actual number of elements
+	size_t deletedCount; ///< Number of deleted buckets, they still lengthen the probe sequences
+	float maxLoad; ///< Resize when (count + deletedCount + 1) / buckets reaches this, must be below 1
 	Hash hasher; ///< The hash functor
 	IndexProbe nextIndex; ///< Functor to access next index
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+	ResizeCounter resizes; ///< Number of and time spent in resizes, for stats()
+	mutable LookupSampler sampler; ///< Probe counts of sampled lookups, only with HASH_TABLE_STATS_SAMPLING
+
+	/// Get the initial bucket index for a given hash
+	size_t getIndex(size_t hash) const {
+		return sizePolicy.index(hash, table.size());
+	}
 
-	/// Get the initial bucket index for a given key
-	int getIndex(const K& key) const {
-		return hasher(key) % table.size();
+	/// Check if a used bucket holds key, whose hash is given, the keys are compared only if the stored hash matches
+	template <typename Key>
+	static bool bucketMatches(const Bucket &bucket, size_t hash, const Key &key) {
+		return bucket.mayMatch(hash) && bucket.data.first == key;
 	}
 
-	/// Check if the table needs to be resized
+	/// Check if the table needs to be resized, deleted buckets count towards the load
+	/// The bucket about to be filled is counted too, so even a load factor close to 1 leaves
+	/// a truly empty bucket to terminate the probing
 	bool needsResize() const {
-		const float factor = float(count) / table.size();
-		return factor >= 0.7;
+		const float factor = float(count + deletedCount + 1) / table.size();
+		return factor >= maxLoad;
 	}
 
-	/// Resize and re-hash the table
+	/// Called when the load is reached, if it is mostly deleted buckets re-hash to the same size to drop them
 	void resize() {
-		table_t newTable(table.size() * 2 + 1);
-		// swap with member so we can re-use insert
+		const bool mostlyDeleted = float(count) / table.size() < maxLoad / 2;
+		resize(mostlyDeleted ? table.size() : sizePolicy.grow(table.size()));
+	}
+
+	/// Re-hash the table into newSize buckets
+	void resize(size_t newSize) {
+		ResizeCounter::Scope measure(resizes);
+		table_t newTable(newSize);
+		// swap with member so we can re-use findEmptyBucket
 		newTable.swap(table);
 
-		// since insert is re-used, it will increment count for each element
-		// thus zero it here so the end count is correct
-		count = 0;
+		// the new table has no deleted buckets and no duplicate keys will be inserted
+		// so the first empty bucket is the right place, elements are moved since the old table is discarded
+		deletedCount = 0;
 		for (Bucket & el : newTable) {
-			if (!el.empty && !el.deleted) {
-				// re-use insert to avoid duplicating the collision logic
-				insert(el.data.first, el.data.second);
+			if (!el.empty) {
+				const size_t hash = el.hashOf(el.data.first, hasher);
+				bucket_iterator bucket = findEmptyBucket(hash);
+				bucket->data = std::move(el.data);
+				bucket->setHash(hash);
+				bucket->empty = false;
 			}
 		}
 	}
 
-	/// Convenience wrapper over the nextIndex template
-	int getNextIndex(int index) {
-		return nextIndex(index, table.size());
+	/// Convenience wrapper over the nextIndex template, step is the number of moves made so far plus one
+	/// hash is the getProbeHash of the sequence
+	size_t getNextIndex(size_t index, size_t hash, size_t step) const {
+		return probeNext(nextIndex, index, table.size(), hash, step);
+	}
+
+	/// What the prober gets as the hash on every step of the probe sequence of hash, see probeStart
+	size_t getProbeHash(size_t hash) const {
+		return probeStart(nextIndex, table.size(), hash);
 	}
 
-	/// Find the correct bucket for a given key
-	/// If checkDeleted is set, then finds non deleted buckets
-	/// If nextIndex is guaranteed to walk every index then this will always terminate eventually
-	bucket_iterator findBucket(const K &key, bool checkDeleted) {
-		int idx = getIndex(key);
+	/// Find the first empty bucket in the probe sequence of hash, only for tables without deleted buckets and
+	/// keys that are not in the table, so no key is compared
+	/// Terminates since nextIndex walks every index, see ProbeCoverage
+	bucket_iterator findEmptyBucket(size_t hash) {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t step = 1; !table[idx].empty; step++) {
+			idx = getNextIndex(idx, probeHash, step);
+		}
+		return table.begin() + idx;
+	}
+
+	/// Find the index of the bucket holding key or table.size() if key is not in the table
+	template <typename Key>
+	size_t findIndex(const Key &key) const {
+		if (table.empty()) {
+			return 0;
+		}
+		const size_t hash = hasher(key);
+		return findIndexFrom(key, hash, getIndex(hash));
+	}
 
-		// do endless loop and move checks inside to improve readability
-		while (true) {
-			// can stop on free bucket
-			if (table[idx].empty && (!checkDeleted || checkDeleted && !table[idx].deleted)) {
-				break;
+	/// Same as findIndex, with the key's hash and home bucket already computed
+	template <typename Key>
+	size_t findIndexFrom(const Key &key, size_t hash, size_t idx) const {
+		const size_t probeHash = getProbeHash(hash);
+		for (size_t probes = 1; ; probes++) {
+			const Bucket &bucket = table[idx];
+			// a never used bucket ends the probe sequence, deleted ones are skipped
+			if (bucket.empty && !bucket.deleted) {
+				sampler.record(false, probes);
+				return table.size();
 			}
-			// key could match by might be deleted
-			if (table[idx].data.first == key && (!checkDeleted || checkDeleted && !table[idx].deleted)) {
-				break;
+			if (!bucket.empty && bucketMatches(bucket, hash, key)) {
+				sampler.record(true, probes);
+				return idx;
 			}
-			idx = getNextIndex(idx);
+			idx = getNextIndex(idx, probeHash, probes);
 		}
+	}
 
-		return table.begin() + idx;
+	template <typename Key>
+	bucket_iterator findKey(const Key &key) {
+		return table.begin() + findIndex(key);
+	}
+
+	/// Enables the heterogeneous lookup overloads only for transparent hashers
+	template <typename Key, typename H>
+	using enable_transparent = typename std::enable_if<IsTransparent<H>::value && !std::is_same<Key, K>::value, int>::type;
+
+	/// Walk the probe sequence once for a key that may be inserted
+	/// Returns the bucket with the key or table.end() if not present, in which case
+	/// freeBucket is set to the first deleted or empty bucket where the key can go
+	bucket_iterator findInsertBucket(const K &key, size_t hash, bucket_iterator &freeBucket) {
+		size_t idx = getIndex(hash);
+		const size_t probeHash = getProbeHash(hash);
+		freeBucket = table.end();
+
+		for (size_t step = 1; ; step++) {
+			Bucket &bucket = table[idx];
+			if (bucket.empty) {
+				if (freeBucket == table.end()) {
+					freeBucket = table.begin() + idx;
+				}
+				// only a never used bucket ends the probe sequence, the key could be after a deleted one
+				if (!bucket.deleted) {
+					return table.end();
+				}
+			} else if (bucketMatches(bucket, hash, key)) {
+				return table.begin() + idx;
+			}
+			idx = getNextIndex(idx, probeHash, step);
+		}
 	}
 	
 public:
-	OOHashTable(Hash hash = Hash(), IndexProbe probe = IndexProbe())
-		: table(41)
-		, count(0)
+	/// Allocates nothing, the buckets are created by the first insert
+	OOHashTable(Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: count(0)
+		, deletedCount(0)
+		, maxLoad(0.7f)
 		, hasher(hash)
-		, nextIndex(probe) {}
+		, nextIndex(probe)
+		, sizePolicy(capacity) {}
+
+	/// Construct from a range of key-value pairs, the table is sized once for forward ranges
+	/// For duplicate keys the first one is kept
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	OOHashTable(InputIt first, InputIt last, Hash hash = Hash(), IndexProbe probe = IndexProbe(), Capacity capacity = Capacity())
+		: OOHashTable(hash, probe, capacity) {
+		insert(first, last);
+	}
+
+	/// Number of buckets in the table
+	size_t bucket_count() const {
+		return table.size();
+	}
+
+	float max_load_factor() const {
+		return maxLoad;
+	}
+
+	/// Set the load factor at which the table grows, rehashes now if it is already reached
+	/// Must be below 1 since probing stops only at an empty bucket
+	void max_load_factor(float factor) {
+		assert(factor > 0 && factor < 1);
+		maxLoad = factor;
+		if (!table.empty() && needsResize()) {
+			rehash(0);
+		}
+	}
+
+	/// Set the bucket count to at least buckets and enough for size() elements, re-hashes all elements and drops deleted buckets
+	void rehash(size_t buckets) {
+		// + 1 so the load is strictly below maxLoad and there is room for one insert
+		const size_t needed = std::max(buckets, bucketsForCount(count + 1, maxLoad));
+		resize(sizePolicy.initial(needed));
+	}
+
+	/// Make room for elementCount elements so inserting up to that many does not resize
+	void reserve(size_t elementCount) {
+		const size_t needed = bucketsForCount(elementCount + 1, maxLoad);
+		if (needed > table.size()) {
+			rehash(needed);
+		}
+	}
+
+	/// Write the table to path as a snapshot header followed by the bucket array, so mapped can serve it without deserializing
+	/// Only for keys and values that can be copied as bytes, returns false on any I/O error
+	bool save(const char *path) const {
+		static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<T>::value,
+			"Only tables with trivially copyable keys and values can be saved");
+
+		FILE *file = fopen(path, "wb");
+		if (!file) {
+			return false;
+		}
+
+		const SnapshotHeader header = SnapshotHeader::make(table.size(), count, hashSeed(hasher), HashStore::snapshotFlag,
+			sizeof(Bucket), sizeof(K), sizeof(T));
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+		// buckets are copied into zeroed memory so padding and data of empty buckets are written as zeroes
+		const size_t chunk = 1024;
+		std::vector<unsigned char> buffer(chunk * sizeof(Bucket));
+		for (size_t start = 0; ok && start < table.size(); start += chunk) {
+			const size_t end = std::min(table.size(), start + chunk);
+			std::fill(buffer.begin(), buffer.end(), 0);
+			for (size_t c = start; c < end; c++) {
+				Bucket *out = new (buffer.data() + (c - start) * sizeof(Bucket)) Bucket;
+				out->empty = table[c].empty;
+				out->deleted = table[c].deleted;
+				if (!table[c].empty) {
+					out->data = table[c].data;
+					out->setHash(table[c].hashOf(table[c].data.first, hasher));
+				}
+			}
+			ok = fwrite(buffer.data(), sizeof(Bucket), end - start, file) == end - start;
+		}
+
+		return fclose(file) == 0 && ok;
+	}
 
 	/// Iterator over the key-value pairs in the table
 	class iterator {
@@ -125,11 +311,16 @@ public:
 		/// Pair with const first element so key can be immutable to the user of the iterator
 		typedef std::pair<const K, T> const_pair;
 
+		/// Singular iterator, only usable as a target of assignment, e.g. for find_batch output arrays
+		iterator()
+			: table(nullptr)
+			, element() {}
+
 		/// Get reference to the key value pair
 		const_pair & operator*() {
 			// must return const key pair because caller could change they key and this will
 			// invalidate the HashTable invariants, it is safe to reinterpret cast it to const key since both share same binary layout
-			return reinterpret_cast<const_pair &>(*element);
+			return reinterpret_cast<const_pair &>(element->data);
 		}
 
 		/// Pointer to the key-value pair
@@ -174,21 +365,117 @@ public:
 		return iterator(table, table.end());
 	}
 
-	iterator insert(const K &key, const T&value) {
+	/// Split the elements into up to count ranges of buckets that can be walked independently, e.g. from different threads
+	/// The ranges are invalidated by anything that invalidates iterators
+	std::vector<IteratorRange<iterator>> partitions(size_t count) {
+		return partitionBuckets<iterator>(count, table.size(), [this](size_t position) {
+			return iterator(table, table.begin() + position);
+		});
+	}
+
+	/// Call fn(element) for every element from threads threads, the table must not be modified meanwhile
+	/// fn may change the values and must be safe to call concurrently for different elements
+	template <typename Fn>
+	void parallel_for_each(Fn fn, int threads) {
+		parallelForEach(*this, fn, threads);
+	}
+
+private:
+	/// Look up the key once and if not present construct the value from args in the first free bucket
+	/// Returns iterator to the element and true if it was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		if (table.empty()) {
+			table = table_t(sizePolicy.initial(41));
+		}
+		const size_t hash = hasher(key);
+		bucket_iterator freeBucket;
+		bucket_iterator bucket = findInsertBucket(key, hash, freeBucket);
+		if (bucket != table.end()) {
+			return std::make_pair(iterator(table, bucket), false);
+		}
+
+		// resize only when actually inserting, the new table has no deleted buckets
 		if (needsResize()) {
 			resize();
+			freeBucket = findEmptyBucket(hash);
+		}
+
+		assert(freeBucket->empty || !freeBucket->deleted); // deleted buckets are also marked empty
+		if (freeBucket->deleted) {
+			--deletedCount;
 		}
+		++count;
+		freeBucket->deleted = false;
+		freeBucket->empty = false;
+		freeBucket->setHash(hash);
+		freeBucket->data.first = std::forward<KeyArg>(key);
+		freeBucket->data.second = T(std::forward<Args>(args)...);
+
+		return std::make_pair(iterator(table, freeBucket), true);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		std::pair<iterator, bool> result = tryEmplace(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			result.first.element->data.second = std::forward<Value>(value);
+		}
+		return result;
+	}
+
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
 
-		bucket_iterator bucket = findBucket(key, false); // ignore deleted flag when inserting
-		assert(!bucket->empty || bucket->empty ^ bucket->deleted);
-		if (bucket->empty) {
-			++count;
+	/// Insert a range of key-value pairs without overwriting existing keys, reserves space once for forward ranges
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	void insert(InputIt first, InputIt last) {
+		reserve(count + rangeSizeHint(first, last));
+		for (; first != last; ++first) {
+			tryEmplace(first->first, first->second);
 		}
-		bucket->deleted = false;
-		bucket->empty = false;
-		bucket->data = std::make_pair(key, value);
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
 
-		return iterator(table, bucket);
+	/// Insert or overwrite the value for key, returns iterator to the element and true if it was inserted
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value from args, otherwise do nothing
+	/// Returns iterator to the element and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	/// Returns iterator to the element with that key and true if it was inserted
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		// the key is needed to find the bucket, so the pair is constructed before the lookup
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
 	}
 
 	/// Erase an item and return iterator to the next valid item or end()
@@ -200,6 +487,7 @@ public:
 		assert(!it.element->empty || it.element->empty ^ it.element->deleted);
 		if (!it.element->empty) {
 			--count;
+			++deletedCount;
 			it.element->deleted = it.element->empty = true;
 		}
 
@@ -212,33 +500,121 @@ public:
 		return erase(find(key));
 	}
 
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	iterator erase(const Key &key) {
+		return erase(iterator(table, findKey(key)));
+	}
+
 	/// Get iterator for a given key or end() if key is not inserted
 	iterator find(const K &key) {
-		bucket_iterator bucket = findBucket(key, true); // must not be deleted
-		assert(!bucket->empty || bucket->empty ^ bucket->deleted);
-		if (bucket->empty) {
-			return end();
+		return iterator(table, findKey(key));
+	}
+
+	/// Find an element by any key type the transparent hasher accepts, without converting it to K
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	iterator find(const Key &key) {
+		return iterator(table, findKey(key));
+	}
+
+	/// Look up keys[0, n) and store an iterator to each one, or end() if missing, in out[0, n)
+	/// Keys are hashed and their home buckets prefetched a group at a time before any is probed,
+	/// so the cache misses of a group overlap instead of each lookup waiting for the previous one.
+	/// Returns the number of keys found
+	size_t find_batch(const K *keys, size_t n, iterator *out) {
+		if (table.empty()) {
+			std::fill(out, out + n, end());
+			return 0;
 		}
-		return iterator(table, bucket);
+		// enough lookups in flight to cover memory latency, few enough to keep the prefetched lines in L1
+		const size_t group = 16;
+		size_t hashes[group];
+		size_t home[group];
+		size_t found = 0;
+		for (size_t start = 0; start < n; start += group) {
+			const size_t size = std::min(group, n - start);
+			for (size_t c = 0; c < size; c++) {
+				hashes[c] = hasher(keys[start + c]);
+				home[c] = getIndex(hashes[c]);
+				prefetchRead(&table[home[c]]);
+			}
+			for (size_t c = 0; c < size; c++) {
+				const size_t idx = findIndexFrom(keys[start + c], hashes[c], home[c]);
+				out[start + c] = iterator(table, table.begin() + idx);
+				found += idx != table.size();
+			}
+		}
+		return found;
+	}
+
+	/// Check if key is in the table
+	bool contains(const K &key) const {
+		return findIndex(key) != table.size();
+	}
+
+	template <typename Key, typename H = Hash, enable_transparent<Key, H> = 0>
+	bool contains(const Key &key) const {
+		return findIndex(key) != table.size();
 	}
 
 	/// Get reference to a based on a key, if not present insert default constructed value
-	T & operator[](const K&key) {
-		if (float(count) / table.size() > 0.7) {
-			resize();
-		}
+	T & operator[](const K &key) {
+		return tryEmplace(key).first.element->data.second;
+	}
 
-		iterator element = find(key);
-		if (element != end()) {
-			assert(!element.element->empty || element.element->empty ^ element.element->deleted);
-			return element->second;
-		}
-		
-		return insert(key, T())->second;
+	T & operator[](K &&key) {
+		return tryEmplace(std::move(key)).first.element->data.second;
 	}
 
 	/// Get the number of key-value pairs in the map
-	int size() const {
+	size_t size() const {
 		return count;
 	}
+
+	/// Probe histograms computed by walking the probe sequence from every bucket, O(bucket_count() * average probe length)
+	/// chainLength counts runs of adjacent non empty buckets (including deleted ones), the clusters linear probing walks through
+	HashTableStats stats() const {
+		HashTableStats result;
+		result.size = count;
+		result.bucketCount = table.size();
+		result.loadFactor = table.empty() ? 0 : double(count) / table.size();
+		result.tombstones = deletedCount;
+		resizes.fill(result);
+		sampler.fill(result);
+
+		size_t run = 0;
+		for (size_t idx = 0; idx < table.size(); idx++) {
+			const Bucket &bucket = table[idx];
+			if (bucket.empty && !bucket.deleted) {
+				if (run) {
+					result.chainLength.add(run);
+				}
+				run = 0;
+			} else {
+				++run;
+			}
+
+			if (!bucket.empty) {
+				const size_t hash = bucket.hashOf(bucket.data.first, hasher);
+				const size_t probeHash = getProbeHash(hash);
+				size_t probes = 1;
+				for (size_t probe = getIndex(hash); probe != idx; probes++) {
+					probe = getNextIndex(probe, probeHash, probes);
+				}
+				result.hitProbes.add(probes);
+			}
+
+			// a missing key starting here stops at the first never used bucket,
+			// for probers that use the hash the bucket index stands in for it
+			const size_t probeHash = getProbeHash(idx);
+			size_t probes = 1;
+			for (size_t probe = idx; !table[probe].empty || table[probe].deleted; probes++) {
+				probe = getNextIndex(probe, probeHash, probes);
+			}
+			result.missProbes.add(probes);
+		}
+		if (run) {
+			result.chainLength.add(run);
+		}
+		return result;
+	}
 };
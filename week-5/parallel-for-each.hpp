@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// Part of a table's elements between two iterators, usable in range-for
+/// Partitions of one table hold different elements, so each can be walked by a different thread
+template <typename Iterator>
+struct IteratorRange {
+	Iterator first; ///< First element of the range
+	Iterator last; ///< First element after the range, or the table's end()
+
+	Iterator begin() const {
+		return first;
+	}
+
+	Iterator end() const {
+		return last;
+	}
+};
+
+/// Split bucketCount buckets into up to count ranges of about the same number of buckets
+/// at(position) must return an iterator to the first element in bucket position or after it,
+/// so a range whose buckets are all empty has equal begin and end.
+template <typename Iterator, typename BucketIterator>
+std::vector<IteratorRange<Iterator>> partitionBuckets(size_t count, size_t bucketCount, BucketIterator at) {
+	count = std::max<size_t>(1, std::min(count, bucketCount));
+	std::vector<IteratorRange<Iterator>> result;
+	result.reserve(count);
+	Iterator first = at(0);
+	for (size_t c = 1; c <= count; c++) {
+		Iterator last = at(bucketCount * c / count);
+		result.push_back(IteratorRange<Iterator>{first, last});
+		first = last;
+	}
+	return result;
+}
+
+/// Call fn on every element of the partitions from threads threads, including the calling one
+/// Threads take the next unclaimed partition when done with one, so a few dense partitions do not leave the others idle.
+/// fn gets each element exactly once and may modify the value, calls for different elements run concurrently.
+template <typename Iterator, typename Fn>
+void parallelForEach(const std::vector<IteratorRange<Iterator>> &partitions, Fn &fn, int threads) {
+	std::atomic<size_t> next{0};
+	auto worker = [&partitions, &fn, &next]() {
+		for (size_t idx = next++; idx < partitions.size(); idx = next++) {
+			for (auto &element : partitions[idx]) {
+				fn(element);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int c = 1; c < threads; c++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (std::thread &th : workers) {
+		th.join();
+	}
+}
+
+/// Call fn on every element of table from threads threads, table must have partitions(count)
+template <typename HashTable, typename Fn>
+void parallelForEach(HashTable &table, Fn &fn, int threads) {
+	assert(threads > 0);
+	// more partitions than threads so the load evens out when elements are unevenly spread over the buckets
+	parallelForEach(table.partitions(size_t(threads) * 8), fn, threads);
+}
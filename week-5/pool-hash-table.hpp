@@ -0,0 +1,266 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+
+#include "capacity-policy.hpp"
+
+/// Closed addressing hash table with all entries in one contiguous array
+/// Bucket chains are linked with 32 bit indices into the entry array instead of a vector per bucket,
+/// erased entries go to a free list and are re-used by later inserts.
+/// Rehash only re-links the chains, entries never move, so iterators stay valid until their element is erased.
+/// Iteration is a linear scan over the entry array.
+/// The indices limit the table to 2^31 - 1 entries, inserting past that throws std::length_error like a full std::vector.
+template <typename K, typename T, typename Hash = std::hash<K>, typename Capacity = PowerOfTwoCapacity>
+class PoolHashTable {
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef T value_type;
+	typedef K key_type;
+
+	typedef value_type & reference;
+private:
+	enum : uint32_t {
+		npos = 0x7FFFFFFF, ///< No entry, ends a chain or the free list
+		freeBit = 0x80000000, ///< Set in next of entries that are in the free list
+	};
+
+	struct Entry {
+		pair_type data; ///< Key value pair
+		uint32_t next; ///< Next entry in the bucket chain, or freeBit | next free entry
+
+		template <typename ... Args>
+		Entry(uint32_t next, Args && ... args)
+			: data(std::forward<Args>(args)...)
+			, next(next) {}
+
+		bool isFree() const {
+			return next & freeBit;
+		}
+	};
+
+	typedef std::vector<Entry> entries_type;
+	typedef std::vector<uint32_t> heads_type;
+
+	entries_type entries; ///< All entries, used and free
+	heads_type heads; ///< Index of the first entry of each bucket chain
+	uint32_t freeList; ///< First free entry
+	size_t count; ///< Number of elements inserted in the table
+	Hash hasher; ///< Hasher object
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+
+	/// Get the bucket index for a given key
+	size_t index(const K &key) const {
+		return sizePolicy.index(hasher(key), heads.size());
+	}
+
+	/// Find the entry index for the key or npos
+	uint32_t findEntry(const K &key) const {
+		for (uint32_t idx = heads[index(key)]; idx != npos; idx = entries[idx].next) {
+			if (entries[idx].data.first == key) {
+				return idx;
+			}
+		}
+		return npos;
+	}
+
+	/// Check if table has reached max load factor of 1 element per bucket
+	bool shouldResize() const {
+		return count >= heads.size();
+	}
+
+	/// Re-link all used entries into a bigger bucket array
+	void resize() {
+		heads.assign(sizePolicy.grow(heads.size()), npos);
+		for (uint32_t c = 0; c < entries.size(); c++) {
+			if (!entries[c].isFree()) {
+				uint32_t &head = heads[index(entries[c].data.first)];
+				entries[c].next = head;
+				head = c;
+			}
+		}
+	}
+
+	/// Take an entry from the free list or append a new one, constructs the pair from args and links it as head of its bucket
+	template <typename ... Args>
+	uint32_t allocate(Args && ... args) {
+		uint32_t idx;
+		if (freeList != npos) {
+			idx = freeList;
+			freeList = entries[idx].next & ~uint32_t(freeBit);
+			entries[idx].data = pair_type(std::forward<Args>(args)...);
+		} else {
+			// checked before anything changes, so the table stays usable after the throw
+			if (entries.size() >= npos) {
+				throw std::length_error("PoolHashTable: entry index does not fit in 31 bits");
+			}
+			idx = uint32_t(entries.size());
+			entries.emplace_back(npos, std::forward<Args>(args)...);
+		}
+
+		uint32_t &head = heads[index(entries[idx].data.first)];
+		entries[idx].next = head;
+		head = idx;
+		++count;
+		return idx;
+	}
+
+	/// Unlink the entry from its bucket chain and put it in the free list
+	void release(uint32_t idx) {
+		uint32_t *link = &heads[index(entries[idx].data.first)];
+		while (*link != idx) {
+			link = &entries[*link].next;
+		}
+		*link = entries[idx].next;
+
+		// release any resources held by the pair
+		entries[idx].data = pair_type();
+		entries[idx].next = freeList | freeBit;
+		freeList = idx;
+		--count;
+	}
+
+public:
+	PoolHashTable(Hash hasher = Hash(), Capacity capacity = Capacity())
+		: heads(capacity.initial(32), npos)
+		, freeList(npos)
+		, count(0)
+		, hasher(hasher)
+		, sizePolicy(capacity) {}
+
+	void clear() {
+		entries.clear();
+		heads.assign(sizePolicy.initial(32), npos);
+		freeList = npos;
+		count = 0;
+	}
+
+	class iterator {
+		friend class PoolHashTable;
+		entries_type *entries; ///< Pointer so the iterators can be easily copy-able
+		uint32_t idx; ///< Index of the current entry, entries->size() for end()
+
+		/// Creates iterator at idx and moves it to the first used entry at or after it
+		iterator(entries_type &entries, uint32_t idx)
+			: entries(&entries)
+			, idx(idx)
+		{
+			findNextValid();
+		}
+
+		/// Skip free entries
+		void findNextValid() {
+			while (idx < entries->size() && (*entries)[idx].isFree()) {
+				++idx;
+			}
+		}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		/// Get pair, but cast it to const key, so caller can't edit the key
+		const_pair & operator*() const {
+			// same binary layout, const key protects the table invariants
+			return reinterpret_cast<const_pair &>((*entries)[idx].data);
+		}
+
+		const_pair * operator->() const {
+			return &(operator*());
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		iterator& operator++() {
+			++idx;
+			findNextValid();
+			return *this;
+		}
+
+		bool operator==(const iterator &other) const {
+			return entries == other.entries && idx == other.idx;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/// Iterator to first element or end() if table is empty
+	iterator begin() {
+		return iterator(entries, 0);
+	}
+
+	/// End iterator, can only be used for equality check
+	iterator end() {
+		return iterator(entries, uint32_t(entries.size()));
+	}
+
+	/// Find an element by its key, returns iterator to the element or end() if not found
+	iterator find(const K &key) {
+		const uint32_t idx = findEntry(key);
+		return idx == npos ? end() : iterator(entries, idx);
+	}
+
+	/// Check if key is in the table
+	bool contains(const K &key) const {
+		return findEntry(key) != npos;
+	}
+
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		uint32_t idx = findEntry(key);
+		if (idx != npos) {
+			entries[idx].data.second = value;
+			return iterator(entries, idx);
+		}
+
+		if (shouldResize()) {
+			resize();
+		}
+		return iterator(entries, allocate(key, value));
+	}
+
+	/// Get value reference to an element with given key,
+	/// if key is not in the table, default construct the value and insert it
+	reference operator[](const K &key) {
+		uint32_t idx = findEntry(key);
+		if (idx == npos) {
+			if (shouldResize()) {
+				resize();
+			}
+			idx = allocate(key, T());
+		}
+		return entries[idx].data.second;
+	}
+
+	/// Erase the element pointed by the iterator and return iterator to the next element
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+
+		release(it.idx);
+		it.findNextValid();
+		return it;
+	}
+
+	/// Erase item by key, returns iterator to next valid element
+	/// If key is not in the map, return end() iterator
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get the number of key-value pairs in the table
+	size_t size() const {
+		return count;
+	}
+};
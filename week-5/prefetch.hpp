@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+/// Hint the CPU to start loading the cache line holding address, does nothing where there is no prefetch instruction
+/// Never faults, address does not need to be valid
+inline void prefetchRead(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#else
+	(void)address;
+#endif
+}
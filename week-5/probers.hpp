@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "capacity-policy.hpp"
+
+/// Probers give the next bucket to try in an open addressing table
+/// Called as probe(index, size, hash, step) where step is 1 for the first move away from the home bucket,
+/// 2 for the next one and so on. Probers that only need the index and size may take just (index, size).
+/// A prober may have start(size, hash), computing what every step of a sequence needs once. Its result is then
+/// passed instead of the hash, the tables get it with probeStart before walking a sequence.
+/// ProbeCoverage<Prober, Capacity> must be specialized to true only for capacity policies whose sizes
+/// make the sequence visit every bucket, otherwise lookups for missing keys may never end.
+
+/// Next bucket after index, clusters on runs of consecutive hashes but is the most cache friendly
+struct LinearProber {
+	size_t operator() (size_t index, size_t size) const {
+		// compare instead of modulo to avoid integer division on every probe step
+		return index + 1 == size ? 0 : index + 1;
+	}
+};
+
+/// Moves by 1, 2, 3, ... buckets, so the offsets from the home bucket are the triangular numbers
+/// Breaks up the clusters of linear probing while the first steps stay close to the home bucket
+/// Covers every bucket only for power of two sizes
+struct QuadraticProber {
+	size_t operator() (size_t index, size_t size, size_t, size_t step) const {
+		const size_t next = index + step;
+		return next < size ? next : next % size;
+	}
+};
+
+/// Moves by a stride taken from the hash, so keys with the same home bucket follow different sequences
+/// The stride is odd for power of two sizes and in [1, size - 1] for other sizes, so it is coprime with
+/// both power of two and prime sizes and the sequence covers every bucket
+struct DoubleHashProber {
+	/// Stride of the sequence, the modulo for prime sizes is paid once per sequence instead of on every step
+	size_t start(size_t size, size_t hash) const {
+		// use different bits than the capacity policies do for the home bucket
+		const uint64_t secondary = (uint64_t(hash) * 0xC2B2AE3D27D4EB4Full) >> 32;
+		const bool powerOfTwo = (size & (size - 1)) == 0;
+		return powerOfTwo ? size_t(secondary & uint64_t(size - 1)) | 1 : 1 + size_t(secondary % uint64_t(size - 1));
+	}
+
+	/// stride is what start returned for this sequence
+	size_t operator() (size_t index, size_t size, size_t stride, size_t) const {
+		assert(stride && stride <= size && "DoubleHashProber needs the stride from probeStart, not the hash");
+		const size_t next = index + stride;
+		return next < size ? next : next - size;
+	}
+};
+
+
+/// True if Prober visits every bucket for all sizes Capacity produces
+template <typename Prober, typename Capacity>
+struct ProbeCoverage : std::false_type {};
+
+template <typename Capacity>
+struct ProbeCoverage<LinearProber, Capacity> : std::true_type {};
+
+template <>
+struct ProbeCoverage<QuadraticProber, PowerOfTwoCapacity> : std::true_type {};
+
+template <>
+struct ProbeCoverage<DoubleHashProber, PowerOfTwoCapacity> : std::true_type {};
+
+template <>
+struct ProbeCoverage<DoubleHashProber, PrimeCapacity> : std::true_type {};
+
+
+/// Check if a prober computes per sequence state in start(size, hash)
+template <typename Prober, typename = void>
+struct HasProbeStart : std::false_type {};
+
+template <typename Prober>
+struct HasProbeStart<Prober, decltype(void(std::declval<const Prober &>().start(size_t(), size_t())))> : std::true_type {};
+
+/// Value to pass as the hash to probeNext for the whole probe sequence of hash in a table of size buckets
+template <typename Prober>
+size_t probeStart(const Prober &probe, size_t size, size_t hash) {
+	if constexpr (HasProbeStart<Prober>::value) {
+		return probe.start(size, hash);
+	} else {
+		return hash;
+	}
+}
+
+/// Call probe with the hash and step if it takes them, with only index and size otherwise
+/// hash is the value probeStart returned for the sequence
+template <typename Prober>
+size_t probeNext(const Prober &probe, size_t index, size_t size, size_t hash, size_t step) {
+	if constexpr (std::is_invocable<const Prober &, size_t, size_t, size_t, size_t>::value) {
+		return probe(index, size, hash, step);
+	} else {
+		return probe(index, size);
+	}
+}
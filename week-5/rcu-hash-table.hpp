@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "epoch-reclamation.hpp"
+
+/// Read-copy-update wrapper for read mostly tables, e.g. COHashTable or OOHashTable
+/// Readers look up in the current version through an atomic pointer inside an epoch read section,
+/// they take no lock and do no atomic read-modify-write, so read throughput grows with the cores.
+/// Writers are serialized by a mutex, copy the current version, change the copy and publish it.
+/// Replaced versions are freed once no reader can still see them, see EpochDomain.
+/// Every write copies the whole table, so batch changes with update() or build a new table and assign() it.
+template <typename Table>
+class RcuHashTable {
+public:
+	typedef typename Table::key_type key_type;
+	typedef typename Table::value_type value_type;
+	typedef Table table_type;
+private:
+	typedef key_type K;
+	typedef value_type T;
+
+	std::atomic<Table *> current; ///< Version new readers see, never nullptr
+	EpochDomain &domain; ///< Tracks the readers
+	std::mutex writeMutex; ///< Serializes writers, readers never take it
+	std::vector<std::pair<uint64_t, Table *>> retired; ///< Replaced versions with their retire epoch, guarded by writeMutex
+
+	/// Make next the current version and retire the old one, writeMutex must be held
+	void publish(Table *next) {
+		Table *old = current.load(std::memory_order_relaxed);
+		current.store(next, std::memory_order_release);
+		retired.emplace_back(domain.advance(), old);
+		reclaimRetired();
+	}
+
+	/// Free the retired versions older than every pinned reader, writeMutex must be held
+	void reclaimRetired() {
+		const uint64_t safe = domain.safeEpoch();
+		const auto stillVisible = std::partition(retired.begin(), retired.end(), [safe](const std::pair<uint64_t, Table *> &version) {
+			return version.first >= safe;
+		});
+		for (auto it = stillVisible; it != retired.end(); ++it) {
+			delete it->second;
+		}
+		retired.erase(stillVisible, retired.end());
+	}
+
+public:
+	explicit RcuHashTable(Table table = Table())
+		: current(new Table(std::move(table)))
+		, domain(EpochDomain::instance()) {}
+
+	RcuHashTable(const RcuHashTable &) = delete;
+	RcuHashTable & operator=(const RcuHashTable &) = delete;
+
+	/// There must be no readers left, all versions are freed right away
+	~RcuHashTable() {
+		delete current.load(std::memory_order_relaxed);
+		for (std::pair<uint64_t, Table *> &version : retired) {
+			delete version.second;
+		}
+	}
+
+	/// One version of the table pinned for the life of the snapshot, later writes do not change it
+	/// Only for lookups and iteration, the version is shared with other readers.
+	/// Keep it short lived: every version published meanwhile stays allocated until it is destroyed.
+	class Snapshot {
+		friend class RcuHashTable;
+		EpochGuard guard; ///< Pins before the pointer is read
+		Table *table; ///< The pinned version
+
+		explicit Snapshot(const RcuHashTable &owner)
+			: guard(owner.domain)
+			, table(owner.current.load(std::memory_order_acquire)) {}
+	public:
+		Table & operator*() const {
+			return *table;
+		}
+
+		Table * operator->() const {
+			return table;
+		}
+	};
+
+	/// Pin the current version
+	Snapshot snapshot() const {
+		return Snapshot(*this);
+	}
+
+	/// Copy the value for key into value, returns false if key is not present
+	bool find(const K &key, T &value) const {
+		EpochGuard guard(domain);
+		Table &table = *current.load(std::memory_order_acquire);
+		typename Table::iterator it = table.find(key);
+		if (it == table.end()) {
+			return false;
+		}
+		value = it->second;
+		return true;
+	}
+
+	/// Check if key is present in the current version
+	bool contains(const K &key) const {
+		EpochGuard guard(domain);
+		Table &table = *current.load(std::memory_order_acquire);
+		return table.find(key) != table.end();
+	}
+
+	/// Get the number of key-value pairs in the current version
+	size_t size() const {
+		EpochGuard guard(domain);
+		return current.load(std::memory_order_acquire)->size();
+	}
+
+	/// Copy the current version, call fn with the copy and publish it, readers see either none or all of fn's changes
+	template <typename Function>
+	void update(Function fn) {
+		std::lock_guard<std::mutex> lock(writeMutex);
+		std::unique_ptr<Table> next(new Table(*current.load(std::memory_order_relaxed)));
+		fn(*next);
+		publish(next.release());
+	}
+
+	/// Replace the whole table with one built elsewhere, without copying the current version
+	void assign(Table table) {
+		std::unique_ptr<Table> next(new Table(std::move(table)));
+		std::lock_guard<std::mutex> lock(writeMutex);
+		publish(next.release());
+	}
+
+	/// Insert key-value pair, overwrites the value if key is present
+	/// Returns true if the key was not present before
+	bool insert(const K &key, const T &value) {
+		bool inserted = false;
+		update([&](Table &table) {
+			const size_t before = table.size();
+			table.insert(key, value);
+			inserted = table.size() != before;
+		});
+		return inserted;
+	}
+
+	/// Erase element by key, returns true if it was present
+	/// A missing key publishes nothing
+	bool erase(const K &key) {
+		if (!contains(key)) {
+			return false;
+		}
+		bool erased = false;
+		update([&](Table &table) {
+			typename Table::iterator it = table.find(key);
+			if (it != table.end()) {
+				table.erase(it);
+				erased = true;
+			}
+		});
+		return erased;
+	}
+
+	/// Publish an empty table
+	void clear() {
+		assign(Table());
+	}
+
+	/// Free the replaced versions no reader can see anymore
+	/// Writes do this too, call it when writes stop so the last replaced versions are not kept until the next one
+	void reclaim() {
+		std::lock_guard<std::mutex> lock(writeMutex);
+		reclaimRetired();
+	}
+};
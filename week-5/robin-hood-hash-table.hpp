@@ -0,0 +1,311 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <utility>
+#include <functional>
+
+#include "capacity-policy.hpp"
+
+/// Open addressing hash table with Robin Hood linear probing and backward shift deletion
+/// Each bucket stores its distance from the home bucket, on insert an element displaces any element
+/// that is closer to its own home, so probe lengths stay short and even. Erase shifts the following
+/// elements one step back instead of leaving tombstones.
+/// The table has maxDistance overflow buckets after the last home bucket and never wraps around, when an
+/// element would need a longer probe the table is rehashed with twice the overflow buckets, so it still fills
+/// up to the max load factor of 0.9 before the home buckets grow.
+template <typename K, typename T, typename Hash = std::hash<K>, typename Capacity = PowerOfTwoCapacity>
+class RobinHoodHashTable
+{
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef K key_type;
+	typedef T value_type;
+
+	typedef value_type & reference;
+private:
+
+	struct Bucket {
+		pair_type data; ///< Key value pair
+		uint32_t distance = 0; ///< 0 for empty bucket, otherwise 1 + distance from the home bucket
+	};
+
+	typedef std::vector<Bucket> table_t;
+
+	table_t table; ///< capacity home buckets followed by maxDistance overflow buckets
+	size_t capacity; ///< Number of home buckets
+	uint32_t maxDistance; ///< Longest allowed probe, also the number of overflow buckets
+	size_t count; ///< Actual number of elements
+	Hash hasher; ///< The hash functor
+	Capacity sizePolicy; ///< Decides bucket count and maps hashes to buckets
+
+	/// Get the home bucket index for a given key
+	size_t getIndex(const K &key) const {
+		return sizePolicy.index(hasher(key), capacity);
+	}
+
+	/// Expected longest probe is logarithmic in the table size for a reasonable hash
+	static uint32_t defaultMaxDistance(size_t capacity) {
+		uint32_t result = 4;
+		while ((size_t(1) << result) < capacity) {
+			++result;
+		}
+		return result;
+	}
+
+	/// Check if inserting one more element exceeds the max load factor of 0.9
+	bool needsResize() const {
+		return (count + 1) * 10 > capacity * 9;
+	}
+
+	/// Find the bucket index of a key or table.size() if not present
+	size_t findIndex(const K &key) const {
+		size_t idx = getIndex(key);
+		// elements are ordered by distance, so stop once the bucket is closer to home than the key would be
+		for (uint32_t distance = 1; distance <= table[idx].distance; ++distance, ++idx) {
+			if (table[idx].distance == distance && table[idx].data.first == key) {
+				return idx;
+			}
+		}
+		return table.size();
+	}
+
+	/// Robin Hood insert of an element not present in the table
+	/// @param carry - the element to insert, on failure holds the element that could not be placed
+	/// @param placed - set to the bucket where the initial element of carry ended up, table.size() if it did not
+	/// @return - false if some element would exceed maxDistance
+	bool place(pair_type &carry, size_t &placed) {
+		placed = table.size();
+		size_t idx = sizePolicy.index(hasher(carry.first), capacity);
+		for (uint32_t distance = 1; distance <= maxDistance; ++distance, ++idx) {
+			Bucket &bucket = table[idx];
+			if (bucket.distance == 0) {
+				bucket.data = std::move(carry);
+				bucket.distance = distance;
+				if (placed == table.size()) {
+					placed = idx;
+				}
+				return true;
+			}
+
+			// take the bucket from the richer element and continue inserting it instead
+			if (bucket.distance < distance) {
+				std::swap(bucket.data, carry);
+				std::swap(bucket.distance, distance);
+				if (placed == table.size()) {
+					placed = idx;
+				}
+			}
+		}
+		return false;
+	}
+
+	/// Insert an element known not to be present and return its bucket index, does not update count
+	size_t insertNew(pair_type carry) {
+		if (needsResize()) {
+			grow();
+		}
+
+		size_t placed;
+		if (place(carry, placed)) {
+			return placed;
+		}
+
+		if (placed == table.size()) {
+			// nothing was displaced, carry is still the new element
+			grow();
+			return insertNew(std::move(carry));
+		}
+
+		// the new element is in the table and some displaced one was left over
+		const K key = table[placed].data.first;
+		grow();
+		insertNew(std::move(carry));
+		return findIndex(key);
+	}
+
+	/// Resize after an insert failed or the load got too high
+	void grow() {
+		// below the max load a long probe only needs more overflow buckets, growing there would cap the load at 0.7-0.8
+		if (!needsResize()) {
+			resize(capacity, maxDistance * 2);
+		} else {
+			const size_t newCapacity = sizePolicy.grow(capacity);
+			resize(newCapacity, std::max(defaultMaxDistance(newCapacity), maxDistance));
+		}
+	}
+
+	/// Re-hash the table into newCapacity home buckets
+	void resize(size_t newCapacity, uint32_t newMaxDistance) {
+		table_t newTable(newCapacity + newMaxDistance);
+		newTable.swap(table);
+		capacity = newCapacity;
+		maxDistance = newMaxDistance;
+
+		std::vector<pair_type> overflow;
+		for (Bucket &el : newTable) {
+			if (el.distance) {
+				size_t placed;
+				if (!place(el.data, placed)) {
+					overflow.push_back(std::move(el.data));
+				}
+			}
+		}
+
+		// elements that did not fit will resize again through insertNew
+		count -= overflow.size();
+		for (pair_type &el : overflow) {
+			insertNew(std::move(el));
+			++count;
+		}
+	}
+
+	/// Remove the element at idx and shift back the following elements that are not in their home bucket
+	void removeAt(size_t idx) {
+		size_t next = idx + 1;
+		while (next < table.size() && table[next].distance > 1) {
+			table[idx].data = std::move(table[next].data);
+			table[idx].distance = table[next].distance - 1;
+			idx = next++;
+		}
+		// release any resources held by the pair
+		table[idx].data = pair_type();
+		table[idx].distance = 0;
+		--count;
+	}
+
+public:
+	RobinHoodHashTable(Hash hash = Hash(), Capacity policy = Capacity())
+		: capacity(policy.initial(32))
+		, maxDistance(defaultMaxDistance(capacity))
+		, count(0)
+		, hasher(hash)
+		, sizePolicy(policy)
+	{
+		table.resize(capacity + maxDistance);
+	}
+
+	/// Iterator over the key-value pairs in the table
+	class iterator {
+		friend class RobinHoodHashTable;
+		table_t *table; ///< Pointer to the table, not reference so the class can have operator=
+		size_t index; ///< Bucket index, table->size() for end()
+
+		/// Construct from some bucket and move to the first valid element or the end() iterator
+		iterator(table_t &table, size_t index)
+			: table(&table)
+			, index(index)
+		{
+			validateIterator();
+		}
+
+		/// If the current iterator points to empty bucket move it forward until end() or valid bucket
+		void validateIterator() {
+			while (index < table->size() && (*table)[index].distance == 0) {
+				++index;
+			}
+		}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		/// Get reference to the key value pair
+		const_pair & operator*() const {
+			// same binary layout, const key protects the table invariants
+			return reinterpret_cast<const_pair &>((*table)[index].data);
+		}
+
+		/// Pointer to the key-value pair
+		const_pair * operator->() const {
+			return &(operator*());
+		}
+
+		/// Prefix increment
+		iterator& operator++() {
+			++index;
+			validateIterator();
+			return *this;
+		}
+
+		/// Postfix increment
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		/// Equality check, iterators must be from the same table
+		bool operator==(const iterator &other) const {
+			return table == other.table && index == other.index;
+		}
+
+		/// Opposite of operator==
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/// First valid key-value pair or end() if table is empty
+	iterator begin() {
+		return iterator(table, 0);
+	}
+
+	/// End iterator can be used only for equality checks
+	iterator end() {
+		return iterator(table, table.size());
+	}
+
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		size_t idx = findIndex(key);
+		if (idx == table.size()) {
+			idx = insertNew(std::make_pair(key, value));
+			++count;
+		} else {
+			table[idx].data.second = value;
+		}
+		return iterator(table, idx);
+	}
+
+	/// Erase an item and return iterator to the next valid item or end()
+	/// Backward shift moves the next element into the erased bucket, so the iterator stays in place
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+		assert(table[it.index].distance != 0);
+
+		removeAt(it.index);
+		it.validateIterator();
+		return it;
+	}
+
+	/// Erase element by key and return iterator to next element in map or end()
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get iterator for a given key or end() if key is not inserted
+	iterator find(const K &key) {
+		return iterator(table, findIndex(key));
+	}
+
+	/// Get reference to a value based on a key, if not present insert default constructed value
+	T & operator[](const K &key) {
+		size_t idx = findIndex(key);
+		if (idx == table.size()) {
+			idx = insertNew(std::make_pair(key, T()));
+			++count;
+		}
+		return table[idx].data.second;
+	}
+
+	/// Get the number of key-value pairs in the map
+	size_t size() const {
+		return count;
+	}
+};
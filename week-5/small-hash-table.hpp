@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "co-hash-table.hpp"
+
+/// Map storing up to N elements inline in the object and searching them linearly, for the many maps that stay tiny
+/// Inserting the N+1-th element moves everything into a heap allocated Table, which is kept until clear().
+/// Nothing is allocated before that, Table's own allocation also waits for its first insert.
+/// Table must have the COHashTable/OOHashTable interface with iterators dereferencing to std::pair<const K, T> &.
+template <typename K, typename T, int N = 8, typename Table = COHashTable<K, T>>
+class SmallHashTable {
+	static_assert(N > 0, "SmallHashTable needs room for at least one inline element");
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef T value_type;
+	typedef K key_type;
+
+	typedef value_type & reference;
+private:
+	pair_type small[N]; ///< Inline elements, [0, smallCount) are used, the rest are default constructed
+	int smallCount; ///< Number of inline elements, 0 once large is used
+	std::unique_ptr<Table> large; ///< All elements after the first overflow, nullptr before it
+
+	/// Index of the inline element with key or -1
+	int findSmall(const K &key) const {
+		for (int c = 0; c < smallCount; c++) {
+			if (small[c].first == key) {
+				return c;
+			}
+		}
+		return -1;
+	}
+
+	/// Move the inline elements to a new Table
+	void grow() {
+		large.reset(new Table());
+		large->reserve(N + 1);
+		for (int c = 0; c < smallCount; c++) {
+			large->insert(std::move(small[c].first), std::move(small[c].second));
+			// release whatever the moved from element still holds
+			small[c] = pair_type();
+		}
+		smallCount = 0;
+	}
+
+public:
+	SmallHashTable()
+		: smallCount(0) {}
+
+	SmallHashTable(const SmallHashTable &other)
+		: smallCount(other.smallCount)
+		, large(other.large ? new Table(*other.large) : nullptr)
+	{
+		std::copy(other.small, other.small + other.smallCount, small);
+	}
+
+	/// Moved from tables are empty
+	SmallHashTable(SmallHashTable &&other)
+		: smallCount(other.smallCount)
+		, large(std::move(other.large))
+	{
+		std::move(other.small, other.small + other.smallCount, small);
+		other.clear();
+	}
+
+	SmallHashTable & operator=(const SmallHashTable &other) {
+		if (this != &other) {
+			SmallHashTable copy(other);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	SmallHashTable & operator=(SmallHashTable &&other) {
+		if (this != &other) {
+			clear();
+			std::move(other.small, other.small + other.smallCount, small);
+			smallCount = other.smallCount;
+			large = std::move(other.large);
+			other.clear();
+		}
+		return *this;
+	}
+
+	/// Remove all elements and free the Table if there is one, the map is inline again
+	void clear() {
+		for (int c = 0; c < smallCount; c++) {
+			small[c] = pair_type();
+		}
+		smallCount = 0;
+		large.reset();
+	}
+
+	/// True while the elements are stored inline
+	bool isSmall() const {
+		return !large;
+	}
+
+	class iterator {
+		friend class SmallHashTable;
+		pair_type *element; ///< Current inline element, nullptr when walking large
+		std::optional<typename Table::iterator> largeIt; ///< Current element of large, empty for inline elements
+
+		explicit iterator(pair_type *element)
+			: element(element) {}
+
+		explicit iterator(typename Table::iterator it)
+			: element(nullptr)
+			, largeIt(it) {}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		const_pair & operator*() {
+			// same binary layout, const key protects the table invariants
+			return element ? reinterpret_cast<const_pair &>(*element) : **largeIt;
+		}
+
+		const_pair * operator->() {
+			return &(operator*());
+		}
+
+		iterator& operator++() {
+			if (element) {
+				++element;
+			} else {
+				++*largeIt;
+			}
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		bool operator==(const iterator &other) const {
+			return element ? element == other.element : other.largeIt && *largeIt == *other.largeIt;
+		}
+
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	iterator begin() {
+		return large ? iterator(large->begin()) : iterator(small);
+	}
+
+	iterator end() {
+		return large ? iterator(large->end()) : iterator(small + smallCount);
+	}
+
+	iterator find(const K &key) {
+		if (large) {
+			return iterator(large->find(key));
+		}
+		const int idx = findSmall(key);
+		return idx >= 0 ? iterator(small + idx) : end();
+	}
+
+	bool contains(const K &key) const {
+		return large ? large->contains(key) : findSmall(key) >= 0;
+	}
+
+private:
+	/// Look up the key and if not present construct the value from args and insert it
+	/// Returns iterator to the element and true if it was inserted
+	template <typename KeyArg, typename ... Args>
+	std::pair<iterator, bool> tryEmplace(KeyArg &&key, Args && ... args) {
+		if (!large) {
+			const int idx = findSmall(key);
+			if (idx >= 0) {
+				return std::make_pair(iterator(small + idx), false);
+			}
+			if (smallCount < N) {
+				pair_type &slot = small[smallCount++];
+				slot.first = std::forward<KeyArg>(key);
+				slot.second = T(std::forward<Args>(args)...);
+				return std::make_pair(iterator(&slot), true);
+			}
+			grow();
+		}
+		std::pair<typename Table::iterator, bool> result = large->try_emplace(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+		return std::make_pair(iterator(result.first), result.second);
+	}
+
+	/// Insert or overwrite the value for key
+	template <typename KeyArg, typename Value>
+	std::pair<iterator, bool> insertOrAssign(KeyArg &&key, Value &&value) {
+		// value is only forwarded if the key is inserted, so it can still be assigned otherwise
+		std::pair<iterator, bool> result = tryEmplace(std::forward<KeyArg>(key), std::forward<Value>(value));
+		if (!result.second) {
+			result.first->second = std::forward<Value>(value);
+		}
+		return result;
+	}
+
+public:
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		return insertOrAssign(key, value).first;
+	}
+
+	/// Insert key-value pair moving both, if key is already present in the table, overwrites the value
+	iterator insert(K &&key, T &&value) {
+		return insertOrAssign(std::move(key), std::move(value)).first;
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(const K &key, Value &&value) {
+		return insertOrAssign(key, std::forward<Value>(value));
+	}
+
+	template <typename Value>
+	std::pair<iterator, bool> insert_or_assign(K &&key, Value &&value) {
+		return insertOrAssign(std::move(key), std::forward<Value>(value));
+	}
+
+	/// If key is not present construct its value from args, otherwise do nothing
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(const K &key, Args && ... args) {
+		return tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		return tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/// Construct key-value pair from args and insert it if the key is not present
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace(Args && ... args) {
+		pair_type element(std::forward<Args>(args)...);
+		return tryEmplace(std::move(element.first), std::move(element.second));
+	}
+
+	/// Get value reference to an element with given key,
+	/// if key is not in the table, default construct the value and insert it
+	reference operator[](const K &key) {
+		return tryEmplace(key).first->second;
+	}
+
+	reference operator[](K &&key) {
+		return tryEmplace(std::move(key)).first->second;
+	}
+
+	/// Erase the element pointed by the iterator and return iterator to the next element
+	/// An inline element is replaced by the last one, so the returned iterator points to the same position
+	iterator erase(iterator it) {
+		if (large) {
+			return iterator(large->erase(*it.largeIt));
+		}
+		if (it == end()) {
+			return it;
+		}
+		pair_type &last = small[--smallCount];
+		if (it.element != &last) {
+			*it.element = std::move(last);
+		}
+		last = pair_type();
+		return it;
+	}
+
+	/// Erase item by key, returns iterator to next valid element
+	/// If key is not in the map, return end() iterator
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get the number of key-value pairs in the table
+	size_t size() const {
+		return large ? large->size() : smallCount;
+	}
+};
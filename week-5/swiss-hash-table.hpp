@@ -0,0 +1,381 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <utility>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWISS_HASH_TABLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/// Group of 16 control bytes matched at once, with SSE2 when available
+/// Each control byte is either Empty, Deleted or the lower 7 bits of the hash of the element in the slot
+struct ControlGroup {
+	enum : int {
+		width = 16 ///< Number of slots in a group
+	};
+
+	enum : int8_t {
+		empty = -128, ///< 0b10000000
+		deleted = -2, ///< 0b11111110
+	};
+
+	/// Bit mask of matched slots in the group, bit N is set if slot N matches
+	typedef uint32_t mask_type;
+
+	/// Slot is occupied when the sign bit is clear
+	static bool isFull(int8_t ctrl) {
+		return ctrl >= 0;
+	}
+
+#ifdef SWISS_HASH_TABLE_SSE2
+	__m128i ctrl;
+
+	explicit ControlGroup(const int8_t *pos)
+		: ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+	/// All slots with control byte equal to the given hash fragment
+	mask_type match(int8_t h2) const {
+		return mask_type(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+	}
+
+	/// All empty slots, deleted ones are not included
+	mask_type matchEmpty() const {
+		return match(empty);
+	}
+
+	/// Both empty and deleted have the sign bit set so movemask finds them directly
+	mask_type matchEmptyOrDeleted() const {
+		return mask_type(_mm_movemask_epi8(ctrl));
+	}
+#else
+	const int8_t *ctrl;
+
+	explicit ControlGroup(const int8_t *pos)
+		: ctrl(pos) {}
+
+	mask_type match(int8_t h2) const {
+		mask_type result = 0;
+		for (int c = 0; c < width; c++) {
+			result |= mask_type(ctrl[c] == h2) << c;
+		}
+		return result;
+	}
+
+	mask_type matchEmpty() const {
+		return match(empty);
+	}
+
+	mask_type matchEmptyOrDeleted() const {
+		mask_type result = 0;
+		for (int c = 0; c < width; c++) {
+			result |= mask_type(!isFull(ctrl[c])) << c;
+		}
+		return result;
+	}
+#endif
+
+	/// Index of the lowest set bit, mask must not be 0
+	/// A single tzcnt/bsf instruction where the compiler has one, the loop is the portable fallback
+	static int lowestBit(mask_type mask) {
+		assert(mask && "No bits set");
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward(&idx, mask);
+		return int(idx);
+#else
+		int idx = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			++idx;
+		}
+		return idx;
+#endif
+	}
+};
+
+
+/// Open addressing hash table with separate control byte array (Swiss table layout)
+/// Probing compares 16 control bytes at a time and touches keys only on 7-bit hash fragment match
+/// Capacity is always a power of two multiple of the group width
+template <typename K, typename T, typename Hash = std::hash<K>>
+class SwissHashTable
+{
+public:
+	typedef std::pair<K, T> pair_type;
+
+	typedef K key_type;
+	typedef T value_type;
+
+	typedef value_type & reference;
+private:
+	typedef std::vector<int8_t> control_t;
+	typedef std::vector<pair_type> slots_t;
+
+	control_t ctrl; ///< One control byte per slot
+	slots_t slots; ///< Key value pairs, valid only where control byte is full
+	size_t count; ///< Number of elements
+	size_t deletedCount; ///< Number of deleted control bytes, they count towards the load
+	Hash hasher; ///< The hash functor
+
+	/// Position in the probe sequence over the groups
+	/// Triangular steps over power of two group count visit each group exactly once
+	struct ProbeSeq {
+		size_t group;
+		size_t mask;
+		size_t step = 0;
+
+		ProbeSeq(uint64_t h1, size_t groupCount)
+			: group(size_t(h1) & (groupCount - 1))
+			, mask(groupCount - 1) {}
+
+		void next() {
+			++step;
+			group = (group + step) & mask;
+		}
+
+		size_t offset() const {
+			return group * ControlGroup::width;
+		}
+	};
+
+	/// Spread the bits of the user hash, std::hash is identity for integers
+	static uint64_t mix(size_t hash) {
+		return uint64_t(hash) * 0x9E3779B97F4A7C15ull;
+	}
+
+	/// Bits selecting the first group to probe
+	static uint64_t h1(uint64_t hash) {
+		return hash ^ (hash >> 32);
+	}
+
+	/// 7 bit fragment stored in the control byte, the high bits are best mixed by the multiply
+	static int8_t h2(uint64_t hash) {
+		return int8_t(hash >> 57);
+	}
+
+	size_t groupCount() const {
+		return ctrl.size() / ControlGroup::width;
+	}
+
+	/// Check if inserting one more element needs a resize, max load factor is 7/8
+	bool needsResize() const {
+		return (count + deletedCount + 1) * 8 > ctrl.size() * 7;
+	}
+
+	/// Find the slot index for the key or ctrl.size() if not present
+	size_t findIndex(const K &key) const {
+		const uint64_t hash = mix(hasher(key));
+		const int8_t fragment = h2(hash);
+		for (ProbeSeq seq(h1(hash), groupCount()); ; seq.next()) {
+			const ControlGroup group(ctrl.data() + seq.offset());
+			for (ControlGroup::mask_type m = group.match(fragment); m; m &= m - 1) {
+				const size_t idx = seq.offset() + ControlGroup::lowestBit(m);
+				if (slots[idx].first == key) {
+					return idx;
+				}
+			}
+			// an empty slot in the group means the key was never inserted further on
+			if (group.matchEmpty()) {
+				return ctrl.size();
+			}
+			assert(seq.step < groupCount() && "Probed the whole table");
+		}
+	}
+
+	/// Find first empty or deleted slot for a given hash, there is always one because of the load factor
+	size_t findFree(uint64_t hash) const {
+		for (ProbeSeq seq(h1(hash), groupCount()); ; seq.next()) {
+			const ControlGroup::mask_type m = ControlGroup(ctrl.data() + seq.offset()).matchEmptyOrDeleted();
+			if (m) {
+				return seq.offset() + ControlGroup::lowestBit(m);
+			}
+			assert(seq.step < groupCount() && "Probed the whole table");
+		}
+	}
+
+	/// Claim a free slot for a key known not to be in the table
+	size_t claim(const K &key) {
+		if (needsResize()) {
+			resize();
+		}
+
+		const uint64_t hash = mix(hasher(key));
+		const size_t idx = findFree(hash);
+		if (ctrl[idx] == ControlGroup::deleted) {
+			--deletedCount;
+		}
+		ctrl[idx] = h2(hash);
+		++count;
+		return idx;
+	}
+
+	/// Re-hash all elements, grows only if the load is not mostly deleted slots
+	void resize() {
+		const size_t newSize = (count + 1) * 2 > ctrl.size() * 7 / 8 ? ctrl.size() * 2 : ctrl.size();
+
+		control_t oldCtrl(newSize, ControlGroup::empty);
+		slots_t oldSlots(newSize);
+		oldCtrl.swap(ctrl);
+		oldSlots.swap(slots);
+		deletedCount = 0;
+
+		for (size_t c = 0; c < oldCtrl.size(); c++) {
+			if (ControlGroup::isFull(oldCtrl[c])) {
+				// no duplicates in the old table so directly find free slot
+				const uint64_t hash = mix(hasher(oldSlots[c].first));
+				const size_t idx = findFree(hash);
+				ctrl[idx] = h2(hash);
+				slots[idx] = std::move(oldSlots[c]);
+			}
+		}
+	}
+
+public:
+	SwissHashTable(Hash hash = Hash())
+		: ctrl(ControlGroup::width * 2, ControlGroup::empty)
+		, slots(ControlGroup::width * 2)
+		, count(0)
+		, deletedCount(0)
+		, hasher(hash) {}
+
+	/// Iterator over the key-value pairs in the table
+	class iterator {
+		friend class SwissHashTable;
+		SwissHashTable *table; ///< Pointer to the table, not reference so the class can have operator=
+		size_t index; ///< Slot index, table->ctrl.size() for end()
+
+		/// Construct from some slot and move to the first valid element or the end() iterator
+		iterator(SwissHashTable &table, size_t index)
+			: table(&table)
+			, index(index)
+		{
+			validateIterator();
+		}
+
+		/// If the current iterator points to non full slot move it forward until end() or valid slot
+		void validateIterator() {
+			while (index < table->ctrl.size() && !ControlGroup::isFull(table->ctrl[index])) {
+				++index;
+			}
+		}
+	public:
+		/// Pair with const first element so key can be immutable to the user of the iterator
+		typedef std::pair<const K, T> const_pair;
+
+		/// Get reference to the key value pair
+		const_pair & operator*() const {
+			// same binary layout, const key protects the table invariants
+			return reinterpret_cast<const_pair &>(table->slots[index]);
+		}
+
+		/// Pointer to the key-value pair
+		const_pair * operator->() const {
+			return &(operator*());
+		}
+
+		/// Prefix increment
+		iterator& operator++() {
+			++index;
+			validateIterator();
+			return *this;
+		}
+
+		/// Postfix increment
+		iterator operator++(int) {
+			iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		/// Equality check, iterators must be from the same table
+		bool operator==(const iterator &other) const {
+			return table == other.table && index == other.index;
+		}
+
+		/// Opposite of operator==
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/// First valid key-value pair or end() if table is empty
+	iterator begin() {
+		return iterator(*this, 0);
+	}
+
+	/// End iterator can be used only for equality checks
+	iterator end() {
+		return iterator(*this, ctrl.size());
+	}
+
+	/// Insert key-value pair, if key is already present in the table, overwrites the value
+	iterator insert(const K &key, const T &value) {
+		size_t idx = findIndex(key);
+		if (idx == ctrl.size()) {
+			idx = claim(key);
+			slots[idx].first = key;
+		}
+		slots[idx].second = value;
+		return iterator(*this, idx);
+	}
+
+	/// Erase an item and return iterator to the next valid item or end()
+	iterator erase(iterator it) {
+		if (it == end()) {
+			return it;
+		}
+		assert(ControlGroup::isFull(ctrl[it.index]));
+
+		// if the group of the slot has an empty one, no probe sequence went past this group
+		// so the slot can become empty instead of a tombstone
+		const size_t groupStart = it.index - it.index % ControlGroup::width;
+		if (ControlGroup(ctrl.data() + groupStart).matchEmpty()) {
+			ctrl[it.index] = ControlGroup::empty;
+		} else {
+			ctrl[it.index] = ControlGroup::deleted;
+			++deletedCount;
+		}
+		// release any resources held by the pair
+		slots[it.index] = pair_type();
+		--count;
+
+		it.validateIterator();
+		return it;
+	}
+
+	/// Erase element by key and return iterator to next element in map or end()
+	iterator erase(const K &key) {
+		return erase(find(key));
+	}
+
+	/// Get iterator for a given key or end() if key is not inserted
+	iterator find(const K &key) {
+		return iterator(*this, findIndex(key));
+	}
+
+	/// Get reference to a value based on a key, if not present insert default constructed value
+	T & operator[](const K &key) {
+		size_t idx = findIndex(key);
+		if (idx == ctrl.size()) {
+			idx = claim(key);
+			slots[idx].first = key;
+		}
+		return slots[idx].second;
+	}
+
+	/// Get the number of key-value pairs in the map
+	size_t size() const {
+		return count;
+	}
+};